@@ -0,0 +1,310 @@
+//
+//  terse_bench.cpp
+//  Terse
+//
+//  Measures the compression and decompression throughput and the compression ratio of Terse for every compression
+//  mode, element type, block size and number of threads, and writes the results as JSON.
+//
+//  Usage: terse_bench [--frames N] [--size HEIGHTxWIDTH] [--repeat N] [--blocks 8-16,20,24,32] [--threads 1,2,4]
+//                     [--types uint16,float] [--modes Signed,Unsigned,Small_unsigned,Float] [--output results.json]
+//
+//  The data resemble diffraction images: a low Poisson background with bright spots and, for unsigned types, a few
+//  overloaded (saturated) pixels. For each configuration the frames are compressed concurrently into a
+//  Terse<Concurrent> object and unpacked again; the best and the median time of 'repeat' runs are reported, and the
+//  unpacked frames are checked against the original data.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "Concurrent.hpp"
+#include "Terse.hpp"
+
+using namespace jpa;
+
+namespace {
+
+struct Options {
+    std::size_t frames = 16;
+    std::size_t height = 512;
+    std::size_t width = 512;
+    std::size_t repeat = 3;
+    std::vector<std::size_t> blocks {8, 12, 16, 24, 32};
+    std::vector<unsigned> threads;
+    std::vector<std::string> types;
+    std::vector<std::string> modes;
+    std::string output;
+};
+
+struct Timing {
+    double best = 0;    // Seconds
+    double median = 0;  // Seconds
+};
+
+struct Result {
+    std::string type;
+    std::string mode;
+    std::size_t block;
+    unsigned threads;
+    double ratio;
+    Timing compress;
+    Timing decompress;
+    bool verified;
+};
+
+std::vector<std::string> split(std::string_view const list) {
+    std::vector<std::string> items;
+    for (std::size_t begin = 0; begin <= list.size(); ) {
+        std::size_t const end = std::min(list.find(',', begin), list.size());
+        if (end != begin) items.emplace_back(list.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    return items;
+}
+
+// Parses a list of numbers and ranges, e.g. "8-16,20,24,32".
+template <typename N>
+std::vector<N> numbers(std::string_view const list) {
+    std::vector<N> values;
+    for (std::string const& item : split(list)) {
+        std::size_t const dash = item.find('-');
+        N const first = static_cast<N>(std::stoul(item.substr(0, dash)));
+        N const last = dash == std::string::npos ? first : static_cast<N>(std::stoul(item.substr(dash + 1)));
+        for (N value = first; value <= last; ++value) values.push_back(value);
+    }
+    return values;
+}
+
+Options parse(int const argc, char const* const* const argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view const option = argv[i];
+        if (option == "--help" || option == "-h") {
+            std::cout << "Usage: terse_bench [--frames N] [--size HEIGHTxWIDTH] [--repeat N] [--blocks 8-16,20,24,32]\n"
+                         "                   [--threads 1,2,4] [--types uint16,float]\n"
+                         "                   [--modes Signed,Unsigned,Small_unsigned,Float] [--output results.json]\n";
+            std::exit(0);
+        }
+        if (i + 1 == argc)
+            throw std::invalid_argument("Missing value of " + std::string(option));
+        std::string const value = argv[++i];
+        if (option == "--frames") options.frames = std::stoul(value);
+        else if (option == "--size") {
+            std::size_t const x = value.find('x');
+            options.height = std::stoul(value.substr(0, x));
+            options.width = x == std::string::npos ? options.height : std::stoul(value.substr(x + 1));
+        }
+        else if (option == "--repeat") options.repeat = std::max<std::size_t>(1, std::stoul(value));
+        else if (option == "--blocks") options.blocks = numbers<std::size_t>(value);
+        else if (option == "--threads") options.threads = numbers<unsigned>(value);
+        else if (option == "--types") options.types = split(value);
+        else if (option == "--modes") options.modes = split(value);
+        else if (option == "--output") options.output = value;
+        else throw std::invalid_argument("Unknown option " + std::string(option));
+    }
+    if (options.threads.empty()) {
+        for (unsigned n = 1; n < available_cores(); n *= 2) options.threads.push_back(n);
+        options.threads.push_back(available_cores());
+    }
+    return options;
+}
+
+bool selected(std::vector<std::string> const& selection, std::string const& name) {
+    return selection.empty() || std::find(selection.begin(), selection.end(), name) != selection.end();
+}
+
+template <typename T>
+std::string type_name() {
+    if constexpr (std::is_floating_point_v<T>) return sizeof(T) == 4 ? "float" : "double";
+    else return (std::is_signed_v<T> ? "int" : "uint") + std::to_string(8 * sizeof(T));
+}
+
+// Frames that resemble diffraction images.
+template <typename T>
+std::vector<T> diffraction_frames(std::size_t const values) {
+    std::mt19937_64 random(20190430);
+    std::poisson_distribution<int> background(1.5);
+    std::exponential_distribution<double> spot(1.0 / 200);
+    std::uniform_real_distribution<double> uniform;
+    double const max = std::is_floating_point_v<T> ? 1e6 : static_cast<double>(std::numeric_limits<T>::max());
+    std::vector<T> data(values);
+    for (auto& value : data) {
+        double v = background(random);
+        double const u = uniform(random);
+        if (u < 0.001) v += spot(random);
+        if (std::is_signed_v<T>) v -= 2;  // Background subtracted
+        if (std::is_unsigned_v<T> && u > 0.9999) v = max;  // Overloaded pixels
+        if constexpr (std::is_floating_point_v<T>)
+            value = static_cast<T>(v * 0.25 + 0.01 * uniform(random));
+        else
+            value = static_cast<T>(std::clamp(v, static_cast<double>(std::numeric_limits<T>::lowest()), max));
+    }
+    return data;
+}
+
+Timing timing(std::vector<double> seconds) {
+    std::sort(seconds.begin(), seconds.end());
+    return {seconds.front(), seconds[seconds.size() / 2]};
+}
+
+template <typename T>
+Result measure(std::vector<T> const& data, Options const& options, Terse_mode const mode, std::string const& mode_name,
+               std::size_t const block, unsigned const threads) {
+    std::size_t const frame_size = options.height * options.width;
+    double const dop = threads == 1 ? 0.0 : std::min(1.0, static_cast<double>(threads) / available_cores());
+    std::vector<double> compress_seconds, decompress_seconds;
+    std::vector<T> unpacked(data.size());
+    Result result {type_name<T>(), mode_name, block, threads, 0, {}, {}, true};
+    for (std::size_t run = 0; run != options.repeat; ++run) {
+        Terse<Concurrent> terse;
+        terse.block_size(block);
+        terse.dop(dop);
+        terse.dim({options.height, options.width});
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t frame = 0; frame != options.frames; ++frame)
+            terse.push_back(std::span(data.data() + frame * frame_size, frame_size), mode);
+        terse.shrink_to_fit();
+        auto stop = std::chrono::steady_clock::now();
+        compress_seconds.push_back(std::chrono::duration<double>(stop - start).count());
+        result.ratio = static_cast<double>(data.size() * sizeof(T)) / static_cast<double>(terse.terse_size());
+
+        std::fill(unpacked.begin(), unpacked.end(), T{});
+        start = std::chrono::steady_clock::now();
+        terse.prolix(unpacked.begin(), 0, terse.number_of_frames());
+        stop = std::chrono::steady_clock::now();
+        decompress_seconds.push_back(std::chrono::duration<double>(stop - start).count());
+        result.verified = result.verified && unpacked == data;
+    }
+    result.compress = timing(compress_seconds);
+    result.decompress = timing(decompress_seconds);
+    return result;
+}
+
+template <typename T>
+void benchmark(Options const& options, std::vector<Result>& results) {
+    if (!selected(options.types, type_name<T>())) return;
+    std::vector<T> const data = diffraction_frames<T>(options.frames * options.height * options.width);
+    std::vector<std::pair<Terse_mode, std::string>> modes;
+    if constexpr (std::is_floating_point_v<T>)
+        modes = {{Terse_mode::Default, "Float"}};
+    else if constexpr (std::is_signed_v<T>)
+        modes = {{Terse_mode::Signed, "Signed"}};
+    else
+        modes = {{Terse_mode::Signed, "Signed"}, {Terse_mode::Unsigned, "Unsigned"}, {Terse_mode::Small_unsigned, "Small_unsigned"}};
+    for (auto const& [mode, mode_name] : modes) {
+        if (!selected(options.modes, mode_name)) continue;
+        for (std::size_t const block : options.blocks)
+            for (unsigned const threads : options.threads) {
+                results.push_back(measure(data, options, mode, mode_name, block, threads));
+                Result const& r = results.back();
+                std::cerr << std::left << std::setw(8) << r.type << std::setw(16) << r.mode << "block " << std::setw(4) << r.block
+                          << "threads " << std::setw(4) << r.threads << std::right << std::fixed << std::setprecision(2)
+                          << "ratio " << std::setw(7) << r.ratio << "  compress " << std::setw(7)
+                          << static_cast<double>(data.size() * sizeof(T)) / r.compress.best / 1e9 << " GB/s  decompress "
+                          << std::setw(7) << static_cast<double>(data.size() * sizeof(T)) / r.decompress.best / 1e9 << " GB/s"
+                          << (r.verified ? "" : "  MISMATCH") << std::endl;
+            }
+    }
+}
+
+std::string json_string(std::string_view const text) {
+    std::string quoted = "\"";
+    for (char const c : text) {
+        if (c == '"' || c == '\\') quoted += '\\';
+        if (static_cast<unsigned char>(c) >= 0x20) quoted += c;
+    }
+    return quoted + "\"";
+}
+
+void write_json(std::ostream& out, Options const& options, std::vector<Result> const& results) {
+    auto const bytes_per_value = [](std::string const& type) {
+        if (type == "float") return 4.0;
+        if (type == "double") return 8.0;
+        return std::stod(type.substr(type.find_first_of("0123456789"))) / 8;
+    };
+    std::time_t const now = std::time(nullptr);
+    char date[32];
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+#if defined(__clang__)
+    std::string const compiler = "clang " __clang_version__;
+#elif defined(__GNUC__)
+    std::string const compiler = "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+    std::string const compiler = "msvc " + std::to_string(_MSC_VER);
+#else
+    std::string const compiler = "unknown";
+#endif
+    double const values = static_cast<double>(options.frames * options.height * options.width);
+    out << std::setprecision(6) << "{\n"
+        << "  \"date\": " << json_string(date) << ",\n"
+        << "  \"compiler\": " << json_string(compiler) << ",\n"
+        << "  \"available_cores\": " << available_cores() << ",\n"
+        << "  \"hardware_concurrency\": " << std::thread::hardware_concurrency() << ",\n"
+        << "  \"frames\": " << options.frames << ",\n"
+        << "  \"frame_dimensions\": [" << options.height << ", " << options.width << "],\n"
+        << "  \"repeat\": " << options.repeat << ",\n"
+        << "  \"results\": [";
+    for (std::size_t i = 0; i != results.size(); ++i) {
+        Result const& r = results[i];
+        double const bytes = values * bytes_per_value(r.type);
+        auto const throughput = [&](Timing const& t) {
+            std::ostringstream s;
+            s << std::setprecision(6) << "{\"GB_per_s\": " << bytes / t.best / 1e9 << ", \"ns_per_value\": "
+              << t.best * 1e9 / values << ", \"best_s\": " << t.best << ", \"median_s\": " << t.median << "}";
+            return s.str();
+        };
+        out << (i == 0 ? "\n" : ",\n") << "    {\"type\": " << json_string(r.type) << ", \"mode\": " << json_string(r.mode)
+            << ", \"block\": " << r.block << ", \"threads\": " << r.threads << ", \"ratio\": " << r.ratio
+            << ", \"compress\": " << throughput(r.compress) << ", \"decompress\": " << throughput(r.decompress)
+            << ", \"verified\": " << (r.verified ? "true" : "false") << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        Options const options = parse(argc, argv);
+        Concurrent::threads(*std::max_element(options.threads.begin(), options.threads.end()));
+        std::vector<Result> results;
+        benchmark<std::uint8_t>(options, results);
+        benchmark<std::uint16_t>(options, results);
+        benchmark<std::uint32_t>(options, results);
+        benchmark<std::uint64_t>(options, results);
+        benchmark<std::int8_t>(options, results);
+        benchmark<std::int16_t>(options, results);
+        benchmark<std::int32_t>(options, results);
+        benchmark<std::int64_t>(options, results);
+        benchmark<float>(options, results);
+        benchmark<double>(options, results);
+        if (options.output.empty())
+            write_json(std::cout, options, results);
+        else {
+            std::ofstream out(options.output);
+            if (!out) throw std::runtime_error("Cannot write " + options.output);
+            write_json(out, options, results);
+        }
+        bool const verified = std::all_of(results.begin(), results.end(), [](Result const& r) { return r.verified; });
+        return verified ? 0 : 2;
+    }
+    catch (std::exception const& e) {
+        std::cerr << "terse_bench: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -14,6 +14,7 @@
 #include <numeric>
 #include <vector>
 #include <concepts>
+#include <cstring>
 
 namespace jpa {
 
@@ -141,7 +142,7 @@ public:
     constexpr void push_back(std::span<T,N> const values) noexcept {
         static_assert(sizeof(T) <= sizeof(std::size_t), "Type too large");
         if constexpr (B != 0) {
-            decltype(d_buffer) const mask = ((1ul << B) - 1);
+            decltype(d_buffer) const mask = B == 64 ? ~decltype(d_buffer)(0) : ((decltype(d_buffer)(1) << B) - 1);
             for (auto const& val : values) {
                 if constexpr (std::is_signed_v<T>)
                     d_buffer |= static_cast<decltype(d_buffer)>(static_cast<std::make_unsigned_t<T>>(val) & mask) << d_buffered_bits;
@@ -152,7 +153,9 @@ public:
                     std::memcpy(d_data, &d_buffer, sizeof(decltype(d_buffer)));
                     d_data += sizeof(decltype(d_buffer));
                     d_buffered_bits -= sizeof(decltype(d_buffer)) * 8;
-                    if constexpr (std::is_signed_v<T>)
+                    if (d_buffered_bits == 0)
+                        d_buffer = 0;
+                    else if constexpr (std::is_signed_v<T>)
                         d_buffer = static_cast<decltype(d_buffer)>(static_cast<std::make_unsigned_t<T>>(val) & mask) >> (B - d_buffered_bits);
                     else
                         d_buffer = static_cast<decltype(d_buffer)>(val) >> (B - d_buffered_bits);
@@ -173,7 +176,7 @@ public:
         static_assert(sizeof(T) <= sizeof(std::size_t), "Type too large");
         assert(B <= sizeof(T) * 8);
         if (B != 0) {
-            decltype(d_buffer) const mask = ((1ul << B) - 1);
+            decltype(d_buffer) const mask = B == 64 ? ~decltype(d_buffer)(0) : ((decltype(d_buffer)(1) << B) - 1);
             for (auto const& val : values) {
                 if constexpr (std::is_signed_v<T>)
                     d_buffer |= static_cast<decltype(d_buffer)>(static_cast<std::make_unsigned_t<T>>(val) & mask) << d_buffered_bits;
@@ -184,7 +187,9 @@ public:
                     std::memcpy(d_data, &d_buffer, sizeof(decltype(d_buffer)));
                     d_data += sizeof(decltype(d_buffer));
                     d_buffered_bits -= sizeof(decltype(d_buffer)) * 8;
-                    if constexpr (std::is_signed_v<T>)
+                    if (d_buffered_bits == 0)
+                        d_buffer = 0;
+                    else if constexpr (std::is_signed_v<T>)
                         d_buffer = static_cast<decltype(d_buffer)>(static_cast<std::make_unsigned_t<T>>(val) & mask) >> (B - d_buffered_bits);
                     else
                         d_buffer = static_cast<decltype(d_buffer)>(val) >> (B - d_buffered_bits);
@@ -241,6 +246,16 @@ public:
         assert(reinterpret_cast<std::uintptr_t>(d_data) % alignof(std::size_t) == 0 && "Container data must be aligned to the size of d_buffer");
         std::memcpy(&d_buffer, d_data, std::min(container.size() * sizeof(*d_data), sizeof(std::size_t)));
     }
+    
+    /**
+     * @brief Constructor that reads from bytes that are not owned by a Bitqueue container, e.g. a memory-mapped file or
+     * a buffer provided by a library. The bytes need not be aligned, but their number must be a multiple of the size of
+     * d_buffer, as for Bitqueue containers.
+     * @param bytes The bytes to read from.
+     */
+    Bitqueue_pop(std::span<std::uint8_t const> const bytes) noexcept : d_data(bytes.data()) {
+        std::memcpy(&d_buffer, d_data, std::min(bytes.size(), sizeof(std::size_t)));
+    }
     /**
      * @brief Retrieves the current readable data pointer.
      * @return Pointer to the current readable data buffer.
@@ -296,7 +311,7 @@ public:
         if (B==0)
             std::fill(values.begin(), values.end(), 0);
         else {
-            T const mask = static_cast<T>((1ul << B) - 1);
+            T const mask = B == 8 * sizeof(T) ? T(~T(0)) : static_cast<T>((std::size_t(1) << B) - 1);
             T const is_negative = std::is_unsigned_v<T> ? T(0) : T(T(1) << (B - 1));
             for (auto& p : values) {
                 p = static_cast<T>(d_buffer);
@@ -312,7 +327,10 @@ public:
                     d_data += sizeof(decltype(d_buffer));
                     std::memcpy(&d_buffer, d_data, sizeof(decltype(d_buffer)));
                     p |= static_cast<T>(d_buffer << d_buffered_bits);
-                    d_buffer >>= B - d_buffered_bits;
+                    if (B - d_buffered_bits == sizeof(decltype(d_buffer)) * 8)
+                        d_buffer = 0;
+                    else
+                        d_buffer >>= B - d_buffered_bits;
                     d_buffered_bits = sizeof(decltype(d_buffer)) * 8 + d_buffered_bits - B;
                 }
                 if (B != 8 * sizeof(T)) {
@@ -350,7 +368,10 @@ public:
                     d_data += sizeof(decltype(d_buffer));
                     std::memcpy(&d_buffer, d_data, sizeof(decltype(d_buffer)));
                     p |= static_cast<T>(d_buffer << d_buffered_bits);
-                    d_buffer >>= B - d_buffered_bits;
+                    if (B - d_buffered_bits == sizeof(decltype(d_buffer)) * 8)
+                        d_buffer = 0;
+                    else
+                        d_buffer >>= B - d_buffered_bits;
                     d_buffered_bits = sizeof(decltype(d_buffer)) * 8 + d_buffered_bits - B;
                 }
                 if constexpr (B != 8 * sizeof(T)) {
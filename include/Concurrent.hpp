@@ -11,8 +11,62 @@
 #include <vector>
 #include <atomic>
 #include <list>
+#include <coroutine>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <bit>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#if defined(__linux__)
+#include <sched.h>
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#endif
 
 namespace jpa {
+/**
+ * @brief Returns the number of cores that this process is allowed to use.
+ *
+ * Unlike `std::thread::hardware_concurrency()`, this takes the CPU affinity mask of the process into account and,
+ * on Linux, a CPU quota that a container runtime or batch scheduler imposes through cgroups (v1 or v2). The result
+ * is determined once, on first use.
+ *
+ * @return The number of usable cores, at least 1.
+ */
+inline unsigned available_cores() noexcept {
+    static unsigned const cores = [] {
+        unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+#if defined(__linux__)
+        cpu_set_t affinity;
+        CPU_ZERO(&affinity);
+        if (sched_getaffinity(0, sizeof(affinity), &affinity) == 0 && CPU_COUNT(&affinity) > 0)
+            cores = static_cast<unsigned>(CPU_COUNT(&affinity));
+        double quota = 0, period = 0;
+        std::ifstream cgroup_v2("/sys/fs/cgroup/cpu.max");
+        std::string quota_v2;
+        if (cgroup_v2 >> quota_v2 >> period && quota_v2 != "max")
+            quota = std::strtod(quota_v2.c_str(), nullptr);
+        else {
+            std::ifstream quota_v1("/sys/fs/cgroup/cpu/cpu.cfs_quota_us");
+            std::ifstream period_v1("/sys/fs/cgroup/cpu/cpu.cfs_period_us");
+            if (!(quota_v1 >> quota && period_v1 >> period))
+                quota = 0;
+        }
+        if (quota > 0 && period > 0)
+            cores = std::clamp(static_cast<unsigned>(std::ceil(quota / period)), 1u, cores);
+#endif
+        return cores;
+    }();
+    return cores;
+}
+
 /**
  * @brief Class to control and represent the degree of parallelism.
  *
@@ -67,7 +121,7 @@ public:
      * @return A reference to the updated `Deg_of_parallelism` object.
      */
     Deg_of_parallelism& cores(unsigned const val) {
-        d_dop = std::clamp(val, 1u, d_cores) / double(d_cores);
+        d_dop = std::clamp(val, 1u, available_cores()) / double(available_cores());
         return *this;
     }
 
@@ -77,12 +131,11 @@ public:
      * @return The number of cores available for concurrent processing, based on the current degree of parallelism.
      */
     unsigned cores() const {
-        return std::clamp(unsigned(d_dop * d_cores), 1u, d_cores);
+        return std::clamp(unsigned(d_dop * available_cores()), 1u, available_cores());
     }
 
 private:
     double d_dop; ///< Degree of parallelism, a value between 0 (sequential) and 1 (full parallelism).
-    static inline unsigned const d_cores = std::max(1u, std::thread::hardware_concurrency()); ///< Total number of available cores on the system.
 };
 
 /**
@@ -90,6 +143,144 @@ private:
  */
 static Deg_of_parallelism degree_of_parallelism_default = Deg_of_parallelism();
 
+/**
+ * @brief A snapshot of the state and the accumulated statistics of the global thread pool used by `Concurrent`.
+ *
+ * A snapshot is obtained with `Concurrent::metrics()`. The instantaneous values (queue depth, running tasks) and the
+ * accumulated counters and histograms are taken consistently under the pool lock, so the histograms always add up to
+ * `completed_tasks`. The accumulated values cover the period since the pool was started or since the last call to
+ * `Concurrent::reset_metrics()`. A task is counted when the worker thread that executed it releases it, which is
+ * after its result has been made available: a snapshot taken right after waiting for a result may not include that
+ * task yet. Collecting the statistics costs two clock reads and a few relaxed atomic increments per task.
+ *
+ * The latency histograms have logarithmic bins: bin 0 counts tasks that took less than 1 µs, and bin i > 0 counts
+ * tasks that took between 2^(i-1) and 2^i µs. The last bin also counts everything that took longer.
+ *
+ * **Example:**
+ * @code
+ * auto m = jpa::Concurrent::metrics();
+ * if (m.queued_tasks > 4 * m.threads)
+ *     std::cerr << "compression backlog: " << m.queued_tasks << " tasks, mean wait "
+ *               << m.mean_wait_time().count() << " ns" << std::endl;
+ * @endcode
+ */
+struct Thread_pool_metrics {
+    static constexpr std::size_t histogram_bins = 32; ///< Number of logarithmic latency bins.
+
+    unsigned threads = 0;                                          ///< Number of worker threads in the pool.
+    unsigned idle_threads = 0;                                     ///< Worker threads not executing a task.
+    std::size_t queued_tasks = 0;                                  ///< Tasks waiting in the queue.
+    std::size_t running_tasks = 0;                                 ///< Tasks being executed by worker threads.
+    std::unordered_map<std::size_t, unsigned> running_per_instance; ///< Running tasks per `Concurrent` instance id.
+    std::uint64_t submitted_tasks = 0;                             ///< Tasks queued in the pool.
+    std::uint64_t completed_tasks = 0;                             ///< Tasks finished by worker threads.
+    std::uint64_t inline_tasks = 0;                                ///< Tasks executed by the caller because the pool was saturated.
+    std::uint64_t cancelled_tasks = 0;                             ///< Queued tasks removed by `Concurrent::cancel()`.
+    std::uint64_t max_queued_tasks = 0;                            ///< High-water mark of the queue depth.
+    std::chrono::nanoseconds total_wait_time {0};                  ///< Summed time tasks spent in the queue.
+    std::chrono::nanoseconds total_run_time {0};                   ///< Summed time worker threads spent executing tasks.
+    std::chrono::nanoseconds elapsed_time {0};                     ///< Time covered by the accumulated statistics.
+    std::array<std::uint64_t, histogram_bins> wait_histogram {};   ///< Queue wait latencies.
+    std::array<std::uint64_t, histogram_bins> run_histogram {};    ///< Task run times.
+
+    /**
+     * @brief Returns the mean time a task spent in the queue before a worker thread picked it up.
+     */
+    std::chrono::nanoseconds mean_wait_time() const noexcept {
+        return completed_tasks == 0 ? std::chrono::nanoseconds(0) : total_wait_time / static_cast<std::int64_t>(completed_tasks);
+    }
+
+    /**
+     * @brief Returns the mean time a worker thread needed to execute a task.
+     */
+    std::chrono::nanoseconds mean_run_time() const noexcept {
+        return completed_tasks == 0 ? std::chrono::nanoseconds(0) : total_run_time / static_cast<std::int64_t>(completed_tasks);
+    }
+
+    /**
+     * @brief Returns the fraction of the available worker time that was spent executing tasks (between 0 and 1).
+     */
+    double utilization() const noexcept {
+        if (threads == 0 || elapsed_time.count() <= 0)
+            return 0;
+        return std::min(1.0, double(total_run_time.count()) / (double(elapsed_time.count()) * threads));
+    }
+
+    /**
+     * @brief Returns the histogram bin that counts a latency of the specified duration.
+     */
+    static std::size_t histogram_bin(std::chrono::nanoseconds const latency) noexcept {
+        auto const us = static_cast<std::uint64_t>(std::max<std::int64_t>(0, latency.count()) / 1000);
+        return std::min<std::size_t>(std::bit_width(us), histogram_bins - 1);
+    }
+};
+
+class Concurrent;
+
+/**
+ * @brief An awaitable handle to a task that runs in the background on the global thread pool.
+ *
+ * An `Awaitable` is returned by `Concurrent::awaitable()`. The task starts as soon as the `Awaitable` is created.
+ * In a C++20 coroutine, `co_await` suspends the coroutine without blocking the calling thread, and the coroutine is
+ * resumed by the worker thread that completes the task (or continues immediately if the task had already completed).
+ * Outside a coroutine, `get()` blocks until the result is available. Exceptions thrown by the task are rethrown by
+ * `co_await` or `get()`. Dropping an `Awaitable` without awaiting it does not cancel or block on the task.
+ *
+ * **Example:**
+ * @code
+ * jpa::Concurrent tasks(1);
+ * // Inside a coroutine, e.g. one driven by an asio-style event loop:
+ * int result = co_await tasks.awaitable(my_function, arg1, arg2);
+ * @endcode
+ *
+ * @tparam T The type of the result of the task.
+ */
+template <typename T>
+class Awaitable {
+    friend class Concurrent;
+
+    struct State {
+        std::future<T> future;
+        std::atomic<void*> continuation {nullptr};
+
+        void complete() noexcept {
+            void* handle = continuation.exchange(this, std::memory_order_acq_rel);
+            if (handle != nullptr)
+                std::coroutine_handle<>::from_address(handle).resume();
+        }
+    };
+
+    std::shared_ptr<State> d_state;
+
+    explicit Awaitable(std::shared_ptr<State> state) noexcept : d_state(std::move(state)) {}
+
+public:
+    /**
+     * @brief Returns true if the task has completed, so that `co_await` does not need to suspend.
+     */
+    bool await_ready() const noexcept { return d_state->continuation.load(std::memory_order_acquire) == d_state.get(); }
+
+    /**
+     * @brief Registers the suspended coroutine for resumption when the task completes.
+     *
+     * @return false if the task completed in the meantime, in which case the coroutine continues immediately.
+     */
+    bool await_suspend(std::coroutine_handle<> const handle) noexcept {
+        void* expected = nullptr;
+        return d_state->continuation.compare_exchange_strong(expected, handle.address(), std::memory_order_acq_rel);
+    }
+
+    /**
+     * @brief Returns the result of the task, or rethrows its exception.
+     */
+    T await_resume() { return d_state->future.get(); }
+
+    /**
+     * @brief Blocks until the task has completed and returns its result, or rethrows its exception.
+     */
+    T get() { return d_state->future.get(); }
+};
+
 /**
  * @brief A concurrent task manager for dispatching and executing different tasks using a thread_local thread pool.
  *
@@ -98,6 +289,11 @@ static Deg_of_parallelism degree_of_parallelism_default = Deg_of_parallelism();
  * This is distinct from parallel processing of a single task divided into subtasks (handled by separate algorithms).
  *
  * The class manages a pool of threads shared by all instances of `Concurrent` to optimize resource use.
+ * The worker threads are only started when the first task is backgrounded, so processes that never
+ * run tasks concurrently do not pay for them. By default the pool has one thread less than the number
+ * of `available_cores()`. The pool size can be set with the environment variable `TERSE_NUM_THREADS`
+ * or at run time with `Concurrent::threads(n)`.
+ *
  * You can run background tasks using `std::future` for standard use cases.
  * It also accepts **functors** for advanced control, such as monitoring, pausing, or stopping tasks while they run.
  *
@@ -158,6 +354,15 @@ static Deg_of_parallelism degree_of_parallelism_default = Deg_of_parallelism();
  * result.get();  // Blocks until the task completes or is killed
  * @endcode
  *
+ * ### Note on fork():
+ *
+ * On POSIX systems the pool survives `fork()`, as done by Python multiprocessing, PyTorch data loaders
+ * or dask. Just before the fork, submissions from threads outside the pool are held back while the
+ * workers keep running the queued tasks, including the nested tasks those submit, until the pool has
+ * drained. The parent then simply continues. In the child, which inherits the queue but none of the
+ * worker threads, a new pool is started on first use (or immediately if the queue is not empty), so
+ * every process can compress and decompress concurrently.
+ *
  * ### Note on Concurrency vs. Parallelism:
  *
  * The `Concurrent` class focuses on concurrent programming—running different tasks simultaneously.
@@ -220,6 +425,81 @@ public:
             (*task)();  // Execute the task immediately
         return result;
     }
+
+    /**
+     * @brief Backgrounds a task for asynchronous execution, returning an object that can be awaited in a coroutine.
+     *
+     * Like `background()`, but instead of a `std::future` an `Awaitable` is returned. Awaiting it with `co_await`
+     * suspends the coroutine without blocking a thread; the coroutine is resumed by the worker thread that completes
+     * the task. If the task is executed immediately (sequential execution or a saturated pool), `co_await` does not
+     * suspend at all.
+     *
+     * @tparam Func The function type.
+     * @tparam Args The argument types for the function.
+     * @param func The function to be executed in the background.
+     * @param args The arguments to be passed to the function.
+     * @return An `Awaitable` representing the result of the task.
+     */
+    template <typename Func, typename... Args>
+    auto awaitable(Func&& func, Args&&... args) -> Awaitable<typename std::invoke_result_t<Func, Args...>> {
+        using return_type = typename std::invoke_result_t<Func, Args...>;
+        auto call = [captured_func = std::forward<Func>(func), ... captured_args = std::forward<Args>(args)]() mutable {
+            if constexpr (std::is_void_v<return_type>)
+                captured_func(std::forward<Args>(captured_args)...);
+            else
+                return captured_func(std::forward<Args>(captured_args)...);
+        };
+        // If the task is cancelled before it runs, the function and the promise are destroyed, and the awaiting coroutine
+        // is resumed to receive the std::future_error of the broken promise.
+        struct Job {
+            std::optional<decltype(call)> function;
+            std::promise<return_type> promise;
+            std::shared_ptr<typename Awaitable<return_type>::State> state;
+            bool ran = false;
+            void run() {
+                try {
+                    if constexpr (std::is_void_v<return_type>) {
+                        (*function)();
+                        promise.set_value();
+                    }
+                    else
+                        promise.set_value((*function)());
+                }
+                catch (...) { promise.set_exception(std::current_exception()); }
+                ran = true;
+                state->complete();
+            }
+            ~Job() {
+                if (ran)
+                    return;
+                function.reset();
+                { auto broken = std::move(promise); }
+                state->complete();
+            }
+        };
+        auto state = std::make_shared<typename Awaitable<return_type>::State>();
+        auto job = std::shared_ptr<Job>(new Job{std::move(call), {}, state});
+        state->future = job->promise.get_future();
+        auto run = [job]() { job->run(); };
+        if (d_dop == 0.0 || !d_thread_pool.f_add_task(*this, run))
+            run();  // Execute the task immediately
+        return Awaitable<return_type>(std::move(state));
+    }
+
+    /**
+     * @brief Removes the tasks of this instance of `Concurrent` that are still waiting in the queue.
+     *
+     * Tasks that are already running are not interrupted; cooperative tasks can be stopped with a `std::stop_token`
+     * of their own. The futures of removed tasks report a `std::future_error` with `std::future_errc::broken_promise`,
+     * and coroutines awaiting a removed task are resumed with that error.
+     *
+     * @return The number of tasks that were removed from the queue.
+     */
+    std::size_t cancel() {
+        if (d_dop == 0.0)
+            return 0;
+        return d_thread_pool.f_cancel(d_unique_id);
+    }
     
     /**
      * @brief Waits until all backgrounded tasks have been completed.
@@ -256,6 +536,40 @@ public:
      */
     constexpr Deg_of_parallelism dop() const noexcept { return d_dop; }
 
+    /**
+     * @brief Returns a snapshot of the queue depth, running tasks, latencies and utilization of the global thread pool.
+     *
+     * @return The `Thread_pool_metrics` of the thread pool shared by all `Concurrent` instances.
+     */
+    static Thread_pool_metrics metrics() { return d_thread_pool.f_metrics(); }
+
+    /**
+     * @brief Resets the accumulated counters and latency histograms of the global thread pool.
+     *
+     * The instantaneous values of the pool (queue depth, running tasks) are not affected.
+     */
+    static void reset_metrics() noexcept { d_thread_pool.f_reset_metrics(); }
+
+    /**
+     * @brief Returns the number of worker threads of the global thread pool.
+     *
+     * If the pool has not been started yet, this is the number of threads it will start with.
+     *
+     * @return The number of worker threads.
+     */
+    static unsigned threads() { return d_thread_pool.f_threads(); }
+
+    /**
+     * @brief Sets the number of worker threads of the global thread pool.
+     *
+     * If the pool is running, it is resized: surplus threads retire after finishing their current task, and
+     * additional threads are started immediately. Queued tasks are not affected. Otherwise, the size is used when
+     * the pool is started.
+     *
+     * @param n The number of worker threads. If 0, the size is taken from the environment variable
+     * `TERSE_NUM_THREADS` or, if that is not set, it is one less than `available_cores()`.
+     */
+    static void threads(unsigned const n) { d_thread_pool.f_resize(n); }
     
 private:
     Deg_of_parallelism d_dop;
@@ -263,71 +577,259 @@ private:
 
     inline static class c_Global_thread_pool {
         friend class Concurrent;
+        using Clock = std::chrono::steady_clock;
 
-        unsigned const d_max_threads = std::max(1u, std::thread::hardware_concurrency() - 1);
-        std::atomic<std::size_t> d_unique_id_generator = 0;
+        unsigned d_requested_threads = 0;
+        unsigned d_max_threads = 0;
+        std::atomic<std::size_t> d_unique_id_generator = 1; // 0 identifies sequential instances
         std::mutex d_mutex;
-        std::list<std::tuple<std::function<void()>, Deg_of_parallelism, std::size_t>> d_task_queue;
+        std::mutex d_resize_mutex;
+        std::list<std::tuple<std::function<void()>, Deg_of_parallelism, std::size_t, Clock::time_point>> d_task_queue;
         std::unordered_map<std::size_t, unsigned> d_running_tasks;
         std::vector<std::thread> d_workers;
         std::condition_variable d_condition;
         std::atomic<bool> d_stop {false};
+        bool d_forking = false;
+        inline static thread_local bool d_is_worker = false;
+
+        std::atomic<std::uint64_t> d_submitted_tasks {0};
+        std::atomic<std::uint64_t> d_completed_tasks {0};
+        std::atomic<std::uint64_t> d_inline_tasks {0};
+        std::atomic<std::uint64_t> d_cancelled_tasks {0};
+        std::atomic<std::uint64_t> d_max_queued_tasks {0};
+        std::atomic<std::int64_t> d_total_wait_ns {0};
+        std::atomic<std::int64_t> d_total_run_ns {0};
+        std::atomic<Clock::rep> d_metrics_start {Clock::now().time_since_epoch().count()};
+        std::array<std::atomic<std::uint64_t>, Thread_pool_metrics::histogram_bins> d_wait_histogram {};
+        std::array<std::atomic<std::uint64_t>, Thread_pool_metrics::histogram_bins> d_run_histogram {};
  
         c_Global_thread_pool() {
-            d_workers.reserve(d_max_threads);
-            for (unsigned i = 0; i < d_max_threads; ++i)
-                d_workers.emplace_back(&c_Global_thread_pool::f_worker_thread, this);
+#if defined(__unix__) || defined(__APPLE__)
+            pthread_atfork([] { d_thread_pool.f_prepare_fork(); },
+                           [] { d_thread_pool.f_parent_after_fork(); },
+                           [] { d_thread_pool.f_child_after_fork(); });
+#endif
         }
 
         ~c_Global_thread_pool() {
-            d_stop = true;
+            {
+                std::lock_guard<std::mutex> lock(d_mutex);
+                d_stop = true;
+            }
             d_condition.notify_all();
-            for (auto& worker : d_workers)
+            f_join(d_workers);
+        }
+
+        static void f_join(std::vector<std::thread>& workers) noexcept {
+            for (auto& worker : workers)
                 if (worker.joinable()) {
-                    try { worker.join(); }
+                    try {
+                        if (worker.get_id() == std::this_thread::get_id())
+                            worker.detach();
+                        else
+                            worker.join();
+                    }
                     catch (const std::system_error& e) {  std::cerr << "Error joining thread: " << e.what() << std::endl; }
                     catch (...) { std::cerr << "Unknown error occurred while joining thread." << std::endl; }
                 }
+            workers.clear();
+        }
+
+        unsigned f_default_threads() const {
+            unsigned threads = d_requested_threads;
+            if (threads == 0)
+                if (char const* env = std::getenv("TERSE_NUM_THREADS"))
+                    threads = static_cast<unsigned>(std::strtoul(env, nullptr, 10));
+            return threads != 0 ? threads : std::max(1u, available_cores() - 1);
+        }
+
+        // Requires d_mutex to be locked.
+        void f_start_workers() {
+            if (d_max_threads != 0)
+                return;
+            d_max_threads = f_default_threads();
+            d_metrics_start = Clock::now().time_since_epoch().count();
+            d_workers.reserve(d_max_threads);
+            for (unsigned i = 0; i < d_max_threads; ++i)
+                d_workers.emplace_back(&c_Global_thread_pool::f_worker_thread, this, i);
+        }
+
+        void f_prepare_fork() {
+            d_resize_mutex.lock();
+            std::unique_lock<std::mutex> lock(d_mutex);
+            d_forking = true;
+            d_condition.notify_all();
+            unsigned const own_task = d_is_worker ? 1 : 0;
+            d_condition.wait(lock, [this, own_task] {
+                unsigned running = 0;
+                for (auto const& [id, count] : d_running_tasks)
+                    running += count;
+                // Queued tasks that no other worker can take are left to the child.
+                return running <= own_task && (d_task_queue.empty() || running >= d_max_threads);
+            });
+            lock.release(); // d_mutex stays locked until after the fork
+        }
+
+        void f_parent_after_fork() {
+            d_forking = false;
+            d_mutex.unlock();
+            d_resize_mutex.unlock();
+            d_condition.notify_all();
+        }
+
+        void f_child_after_fork() {
+            new (&d_condition) std::condition_variable;
+            // The worker threads of the parent do not exist in the child: their handles can be neither joined nor
+            // detached, and are deliberately leaked.
+            new std::vector<std::thread>(std::move(d_workers));
+            d_workers.clear();
+            d_max_threads = 0;
+            d_forking = false;
+            if (!d_task_queue.empty())
+                f_start_workers();
+            d_mutex.unlock();
+            d_resize_mutex.unlock();
+        }
+
+        unsigned f_threads() {
+            std::lock_guard<std::mutex> lock(d_mutex);
+            return d_max_threads != 0 ? d_max_threads : f_default_threads();
+        }
+
+        void f_resize(unsigned const n) {
+            std::lock_guard<std::mutex> resize_lock(d_resize_mutex);
+            std::vector<std::thread> retired;
+            {
+                std::lock_guard<std::mutex> lock(d_mutex);
+                d_requested_threads = n;
+                if (d_max_threads == 0)
+                    return;
+                d_max_threads = f_default_threads();
+                while (d_workers.size() > d_max_threads) {
+                    retired.push_back(std::move(d_workers.back()));
+                    d_workers.pop_back();
+                }
+                for (unsigned i = static_cast<unsigned>(d_workers.size()); i < d_max_threads; ++i)
+                    d_workers.emplace_back(&c_Global_thread_pool::f_worker_thread, this, i);
+            }
+            d_condition.notify_all();
+            f_join(retired);
         }
         
         bool f_add_task(Concurrent const& concurrent_instance, std::function<void()> const& task) {
-            if (d_max_threads == 0)
-                return false;
-            auto top_level_id = f_get_top_level_id();
-            if (top_level_id.has_value() &&
-                concurrent_instance.d_unique_id != *top_level_id &&
-                d_running_tasks.size() == d_max_threads)
-                return false;
             {
-                std::lock_guard<std::mutex> lock(d_mutex);
-                d_task_queue.emplace_back(std::move(task), concurrent_instance.d_dop, concurrent_instance.d_unique_id);
+                std::unique_lock<std::mutex> lock(d_mutex);
+                if (!d_is_worker)
+                    d_condition.wait(lock, [this] { return !d_forking; });
+                f_start_workers();
+                auto top_level_id = f_top_level_id();
+                if (top_level_id.has_value() &&
+                    concurrent_instance.d_unique_id != *top_level_id &&
+                    d_running_tasks.size() >= d_max_threads) {
+                    d_inline_tasks.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                d_task_queue.emplace_back(std::move(task), concurrent_instance.d_dop, concurrent_instance.d_unique_id, Clock::now());
+                std::uint64_t const queued = d_task_queue.size();
+                if (queued > d_max_queued_tasks.load(std::memory_order_relaxed))
+                    d_max_queued_tasks.store(queued, std::memory_order_relaxed);
+                d_submitted_tasks.fetch_add(1, std::memory_order_relaxed);
             }
             d_condition.notify_one();
             return true;
         }
 
-        std::size_t f_get_unique_id() { return d_unique_id_generator++; }
+        std::size_t f_cancel(std::size_t const concurrent_id) {
+            decltype(d_task_queue) cancelled;
+            {
+                std::lock_guard<std::mutex> lock(d_mutex);
+                for (auto it = d_task_queue.begin(); it != d_task_queue.end(); )
+                    if (std::get<2>(*it) == concurrent_id)
+                        cancelled.splice(cancelled.end(), d_task_queue, it++);
+                    else
+                        ++it;
+                d_cancelled_tasks.fetch_add(cancelled.size(), std::memory_order_relaxed);
+            }
+            d_condition.notify_all();
+            return cancelled.size(); // Cancelled tasks are destroyed outside the lock
+        }
+
+        Thread_pool_metrics f_metrics() {
+            Thread_pool_metrics metrics;
+            {
+                std::lock_guard<std::mutex> lock(d_mutex);
+                metrics.threads = d_max_threads;
+                metrics.queued_tasks = d_task_queue.size();
+                metrics.running_per_instance = d_running_tasks;
+                metrics.submitted_tasks = d_submitted_tasks.load(std::memory_order_relaxed);
+                metrics.completed_tasks = d_completed_tasks.load(std::memory_order_relaxed);
+                metrics.inline_tasks = d_inline_tasks.load(std::memory_order_relaxed);
+                metrics.cancelled_tasks = d_cancelled_tasks.load(std::memory_order_relaxed);
+                metrics.max_queued_tasks = d_max_queued_tasks.load(std::memory_order_relaxed);
+                metrics.total_wait_time = std::chrono::nanoseconds(d_total_wait_ns.load(std::memory_order_relaxed));
+                metrics.total_run_time = std::chrono::nanoseconds(d_total_run_ns.load(std::memory_order_relaxed));
+                metrics.elapsed_time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    Clock::now() - Clock::time_point(Clock::duration(d_metrics_start.load(std::memory_order_relaxed))));
+                for (std::size_t i = 0; i != Thread_pool_metrics::histogram_bins; ++i) {
+                    metrics.wait_histogram[i] = d_wait_histogram[i].load(std::memory_order_relaxed);
+                    metrics.run_histogram[i] = d_run_histogram[i].load(std::memory_order_relaxed);
+                }
+            }
+            for (auto const& [id, count] : metrics.running_per_instance)
+                metrics.running_tasks += count;
+            metrics.idle_threads = metrics.threads - std::min<unsigned>(metrics.threads, static_cast<unsigned>(metrics.running_tasks));
+            return metrics;
+        }
 
-        std::optional<std::size_t> f_get_top_level_id() {
+        void f_reset_metrics() noexcept {
             std::lock_guard<std::mutex> lock(d_mutex);
+            d_submitted_tasks = 0;
+            d_completed_tasks = 0;
+            d_inline_tasks = 0;
+            d_cancelled_tasks = 0;
+            d_max_queued_tasks = 0;
+            d_total_wait_ns = 0;
+            d_total_run_ns = 0;
+            for (auto& bin : d_wait_histogram) bin = 0;
+            for (auto& bin : d_run_histogram) bin = 0;
+            d_metrics_start = Clock::now().time_since_epoch().count();
+        }
+
+        // Requires d_mutex to be locked, so that a snapshot of the metrics counts each task in all statistics or in none.
+        void f_record_task(Clock::time_point const queued, Clock::time_point const started, Clock::time_point const finished) noexcept {
+            auto const wait = std::chrono::duration_cast<std::chrono::nanoseconds>(started - queued);
+            auto const run = std::chrono::duration_cast<std::chrono::nanoseconds>(finished - started);
+            d_total_wait_ns.fetch_add(wait.count(), std::memory_order_relaxed);
+            d_total_run_ns.fetch_add(run.count(), std::memory_order_relaxed);
+            d_wait_histogram[Thread_pool_metrics::histogram_bin(wait)].fetch_add(1, std::memory_order_relaxed);
+            d_run_histogram[Thread_pool_metrics::histogram_bin(run)].fetch_add(1, std::memory_order_relaxed);
+            d_completed_tasks.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        std::size_t f_get_unique_id() { return d_unique_id_generator++; }
+
+        // Requires d_mutex to be locked.
+        std::optional<std::size_t> f_top_level_id() const {
             std::optional<std::size_t> top_level_id;
             for (const auto& [id, count] : d_running_tasks)
                 if (!top_level_id || id < *top_level_id)
                     top_level_id = id;
-            for (const auto& [task, dop, id] : d_task_queue)
+            for (const auto& [task, dop, id, queued] : d_task_queue)
                 if (!top_level_id || id < *top_level_id)
                     top_level_id = id;
             return top_level_id;
         }
         
-        void f_worker_thread() {
+        void f_worker_thread(unsigned const index) {
+            d_is_worker = true;
             while (true) {
                 std::function<void()> task;
                 std::size_t concurrent_id;
+                Clock::time_point queued;
                 {
                     std::unique_lock<std::mutex> lock(d_mutex);
-                    d_condition.wait(lock, [this]() { return d_stop || !d_task_queue.empty(); });
-                    if (d_task_queue.empty() && d_stop)
+                    d_condition.wait(lock, [this, index]() { return d_stop || index >= d_max_threads || !d_task_queue.empty(); });
+                    if ((d_task_queue.empty() && d_stop) || index >= d_max_threads)
                         return;
                     auto it = d_task_queue.begin();
                     while (it != d_task_queue.end()) {
@@ -335,6 +837,7 @@ private:
                         concurrent_id = get<2>(*it);
                         if (d_running_tasks[concurrent_id] < dop.cores()) {
                             task = std::move(get<0>(*it));
+                            queued = get<3>(*it);
                             d_task_queue.erase(it);
                             ++d_running_tasks[concurrent_id];
                             break;
@@ -344,11 +847,14 @@ private:
                     if (!task)
                         continue;
                 }
+                auto const started = Clock::now();
                 try { task(); }
                 catch (const std::exception& e) { std::cerr << "Exception in worker thread: " << e.what() << std::endl; }
                 catch (...) { std::cerr << "Unknown exception in worker thread." << std::endl; }
+                auto const finished = Clock::now();
                 {
                     std::lock_guard<std::mutex> lock(d_mutex);
+                    f_record_task(queued, started, finished);
                     if (d_running_tasks[concurrent_id] == 1)
                         d_running_tasks.erase(concurrent_id);
                     else
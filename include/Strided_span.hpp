@@ -0,0 +1,174 @@
+//
+//  Strided_span.hpp
+//  Terse
+//
+//  A non-owning view of a multi-dimensional array with arbitrary strides, such as a slice of a NumPy array.
+//
+
+#ifndef Strided_span_h
+#define Strided_span_h
+
+#include <compare>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+// Strided_span<T>(T* data, std::vector<std::size_t> shape, std::vector<std::ptrdiff_t> byte_strides)
+//      A view of the values of a multi-dimensional array that starts at 'data' and has dimensions 'shape'. Moving one
+//      step along dimension i moves byte_strides[i] bytes through memory; strides may be negative or zero, and need not
+//      be multiples of sizeof(T). The values are iterated in row-major (C) order, so that e.g. a Fortran-ordered array,
+//      a transposed array or a slice such as data[:, ::2] can be compressed by Terse without first being copied into
+//      a contiguous buffer. The view does not own the values: they must outlive the view and its iterators.
+//
+// Member functions:
+//  iterator begin() const noexcept, iterator end() const noexcept
+//      Random-access iterators over the values in row-major order. Stepping along the last dimension adds a stride to
+//      a pointer; only moving to the next row recomputes the address from the indices.
+//  iterator data() const noexcept
+//      Same as begin(). Terse reads the values of a container from data().
+//  std::size_t size() const noexcept
+//      Returns the number of values.
+//  std::vector<std::size_t> const& dim() const noexcept
+//      Returns the dimensions.
+//  bool contiguous() const noexcept
+//      Returns true if the values are stored contiguously in row-major order, from base() up to base() + size().
+//  T* base() const noexcept
+//      Returns the address of the first value.
+//
+// Example:
+//
+//    // Compress every second row of a 512 x 512 frame of 16-bit values without copying it.
+//    jpa::Strided_span<std::uint16_t const> rows(frame.data(), {256, 512}, {2 * 512 * 2, 2});
+//    jpa::Terse<> terse(rows);
+
+namespace jpa {
+
+/**
+ * @class Strided_span
+ * @brief A non-owning view of a multi-dimensional array with arbitrary byte strides, iterated in row-major order.
+ *
+ * @tparam T The type of the values, which may be const.
+ */
+template <typename T>
+class Strided_span {
+    struct Layout {
+        std::vector<std::size_t> shape;
+        std::vector<std::ptrdiff_t> strides;
+        std::ptrdiff_t size;
+    };
+    using byte_pointer = std::conditional_t<std::is_const_v<T>, std::byte const*, std::byte*>;
+
+public:
+    /**
+     * @brief Random-access iterator over the values of a Strided_span, in row-major order.
+     */
+    class iterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = std::remove_cv_t<T>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = T*;
+        using reference = T&;
+
+        iterator() = default;
+
+        reference operator*() const noexcept { return *d_pointer; }
+        pointer operator->() const noexcept { return d_pointer; }
+        reference operator[](difference_type const n) const noexcept { return *(*this + n); }
+
+        iterator& operator++() noexcept {
+            ++d_index;
+            if (++d_column != d_layout->shape.back())
+                d_pointer = reinterpret_cast<pointer>(reinterpret_cast<byte_pointer>(d_pointer) + d_layout->strides.back());
+            else
+                f_locate();
+            return *this;
+        }
+        iterator operator++(int) noexcept { iterator previous = *this; ++*this; return previous; }
+        iterator& operator--() noexcept { --d_index; f_locate(); return *this; }
+        iterator operator--(int) noexcept { iterator previous = *this; --*this; return previous; }
+        iterator& operator+=(difference_type const n) noexcept { d_index += n; f_locate(); return *this; }
+        iterator& operator-=(difference_type const n) noexcept { return *this += -n; }
+        friend iterator operator+(iterator i, difference_type const n) noexcept { return i += n; }
+        friend iterator operator+(difference_type const n, iterator i) noexcept { return i += n; }
+        friend iterator operator-(iterator i, difference_type const n) noexcept { return i -= n; }
+        friend difference_type operator-(iterator const& a, iterator const& b) noexcept { return a.d_index - b.d_index; }
+        friend bool operator==(iterator const& a, iterator const& b) noexcept { return a.d_index == b.d_index; }
+        friend std::strong_ordering operator<=>(iterator const& a, iterator const& b) noexcept { return a.d_index <=> b.d_index; }
+
+    private:
+        friend class Strided_span;
+
+        iterator(Layout const* layout, T* base, difference_type const index) noexcept :
+        d_layout(layout), d_base(base), d_index(index) {
+            f_locate();
+        }
+
+        // Computes the address of the value at d_index from its indices. Iterators outside the view hold no address.
+        void f_locate() noexcept {
+            d_pointer = nullptr;
+            d_column = 0;
+            if (d_index < 0 || d_index >= d_layout->size) return;
+            auto address = reinterpret_cast<byte_pointer>(d_base);
+            auto index = static_cast<std::size_t>(d_index);
+            for (std::size_t i = d_layout->shape.size(); i-- != 0; ) {
+                std::size_t const coordinate = index % d_layout->shape[i];
+                index /= d_layout->shape[i];
+                if (i + 1 == d_layout->shape.size()) d_column = coordinate;
+                address += static_cast<std::ptrdiff_t>(coordinate) * d_layout->strides[i];
+            }
+            d_pointer = reinterpret_cast<pointer>(address);
+        }
+
+        Layout const* d_layout = nullptr;
+        T* d_base = nullptr;
+        pointer d_pointer = nullptr;
+        difference_type d_index = 0;
+        std::size_t d_column = 0;  // The index along the last dimension
+    };
+
+    /**
+     * @brief Constructs a view of the array at 'data' with dimensions 'shape' and strides 'byte_strides' in bytes.
+     *
+     * @throws std::invalid_argument If the numbers of dimensions and strides differ.
+     */
+    Strided_span(T* const data, std::vector<std::size_t> shape, std::vector<std::ptrdiff_t> byte_strides) :
+    d_base(data) {
+        if (shape.size() != byte_strides.size())
+            throw std::invalid_argument("A Strided_span requires one stride per dimension.");
+        if (shape.empty()) {
+            shape.push_back(1);
+            byte_strides.push_back(0);
+        }
+        auto const size = std::accumulate(shape.begin(), shape.end(), std::size_t(1), std::multiplies<>());
+        d_layout = std::make_shared<Layout const>(Layout{std::move(shape), std::move(byte_strides), static_cast<std::ptrdiff_t>(size)});
+    }
+
+    iterator begin() const noexcept { return iterator(d_layout.get(), d_base, 0); }
+    iterator end() const noexcept { return iterator(d_layout.get(), d_base, d_layout->size); }
+    iterator data() const noexcept { return begin(); }
+    std::size_t size() const noexcept { return static_cast<std::size_t>(d_layout->size); }
+    std::vector<std::size_t> const& dim() const noexcept { return d_layout->shape; }
+    T* base() const noexcept { return d_base; }
+
+    bool contiguous() const noexcept {
+        auto stride = static_cast<std::ptrdiff_t>(sizeof(T));
+        for (std::size_t i = d_layout->shape.size(); i-- != 0; ) {
+            if (d_layout->shape[i] != 1 && d_layout->strides[i] != stride) return false;
+            stride *= static_cast<std::ptrdiff_t>(d_layout->shape[i]);
+        }
+        return true;
+    }
+
+private:
+    T* d_base;
+    std::shared_ptr<Layout const> d_layout;  // Shared, so that copies of the view and their iterators stay valid
+};
+
+}  // namespace jpa
+
+#endif /* Strided_span_h */
@@ -17,8 +17,16 @@
 #include <numeric>
 #include <span>
 #include <future>
+#include <chrono>
 #include <algorithm>
 #include <type_traits>
+#include <variant>
+#include <stop_token>
+#include <optional>
+#include <sstream>
+#include <cmath>
+#include <string_view>
+#include <utility>
 #include "Bitqueue.hpp"
 #include "Unique_array.hpp"
 #include "XML_element.hpp"
@@ -113,6 +121,8 @@
 //      of the Terse object. Otherwise the dimensions can be set once using the dim(vector const&) member function.
 //      If the the 'data' parameter is an rvalue and the Terse template parameter C is Concurrent, compression is
 //      branched to a different thread and proceeds concurrently. In this case, the 'data' container is emptied.
+//      The values need not be contiguous: containers with random-access iterators, such as a Strided_span over a slice
+//      of a larger array (see Strided_span.hpp), are compressed block by block through their iterators.
 //  Terse<C>(iterator begin, std::size_t size, Terse_mode const mode = Terse_mode::Signed)
 //      Creates a Terse object given a starting iterator or pointer and the number of elements that need to be
 //      encoded.
@@ -139,9 +149,29 @@
 //      frame.
 //      If the the 'data' parameter is an rvalue and the Terse template parameter C is Concurrent, compression is
 //      branched to a different thread and proceeds concurrently. In this case, the 'data' container is emptied.
+//  Awaitable<void> insert_async(std::size_t const pos, C&& data, Terse_mode const mode = Terse_mode::Default)
+//  Awaitable<void> push_back_async(C&& data, Terse_mode const mode = Terse_mode::Default)
+//      Only for Terse<Concurrent>. As insert() and push_back(), but compression always runs in the background and the
+//      returned object can be awaited with co_await in a C++20 coroutine, without blocking the calling thread.
+//  void insert(std::size_t const pos, C&& data, Terse_mode const mode, F&& on_released)
+//  void push_back(C&& data, Terse_mode const mode, F&& on_released)
+//      As insert() and push_back(), but the callback 'on_released' is invoked as soon as the input data are no longer
+//      referenced, e.g. when a frame that is compressed in the background has finished compressing. This allows input
+//      buffers to be recycled early.
+//  void push_back(Terse_view<C> const& view, std::size_t first = 0, std::size_t count = all)
+//      Appends frames of Terse data held in memory by copying their compressed bytes, without unpacking them.
+//  void push_back(Terse_view<C> const& view, std::shared_ptr<void const> memory, bool lazy = true)
+//      Only for Terse<Concurrent>. Appends all frames of 'view', whose memory (e.g. a memory-mapped file) is kept alive by
+//      'memory'. Each frame is copied when it is first used (lazy), or all frames are copied in parallel in the
+//      background. See also load_terse() in Terse_file.hpp.
 //  void erase(std::size_t pos) noexcept
-//      Removes the frame with index 'pos' from the Terse object. Also waits until concurrent compression has finished,
-//      and releases unused storage to the heap.
+//      Removes the frame with index 'pos' from the Terse object. Does not wait for concurrent compression: a frame
+//      that is removed while it is being compressed is discarded when compression finishes.
+//  std::size_t cancel() noexcept
+//      Only for Terse<Concurrent>. Discards all frames whose concurrent compression has not finished: queued compression
+//      tasks are removed from the thread pool and running ones stop at the next data block. Returns the number of
+//      discarded frames. The destructor and move assignment cancel outstanding compression in the same way. Moving a
+//      Terse<Concurrent> object blocks until compression of the frames of the moved-from object has finished.
 //  Terse at(std::size_t pos) noexcept
 //      Returns the frame with index 'pos' as a Terse object.
 //  void prolix(iterator begin, std::size_t const pos = 0)
@@ -151,9 +181,17 @@
 //      can always be unpacked into signed integral, double and float data and will have the correct sign (with one
 //      exception: an unsigned overflowed - all 1's - value will be unpacked as -1 signed value. As all other values are
 //      positive in this case).
+//  void prolix(iterator begin, std::size_t const first, std::size_t const last)
+//      Unpacks the frames 'first' up to 'last' one after another from the location defined by 'begin'. Terse<Concurrent>
+//      unpacks the frames in parallel.
+//  void prolix(iterator begin, std::span<std::size_t const> const frames)
+//      As above, for the frames with the listed indices, in the order listed. Indices may repeat.
 //  void prolix(container_type& container, std::size_t const pos = 0)
 //      Unpacks the Terse frame with index 'pos' and stores it in the provided container. Also checks the container is
 //      large enough.
+//  Awaitable<void> prolix_async(D&& destination, std::size_t const pos = 0)
+//      Only for Terse<Concurrent>. Unpacks the Terse frame with index 'pos' into a container or from an iterator in the
+//      background. The returned object can be awaited with co_await in a C++20 coroutine.
 //  std::size_t size() const noexcept
 //      Returns the number of encoded elements.
 //  std::size_t const number_of_frames() const
@@ -176,6 +214,17 @@
 //      that are required for constructing a Terse object from the stream. Data are written as a byte stream
 //      and are therefore independent of endian-ness. A small-endian memory lay-out produces the a Terse file
 //      that is identical to a big-endian machine.
+//  std::size_t write(std::uint8_t* destination)
+//      As write(ostream), but writes the same bytes directly into a block of memory of at least file_size() bytes,
+//      without the overhead of a stream. Returns the number of bytes written.
+//  std::size_t write(std::uint8_t* destination, std::string_view header)
+//      As write(destination), with the result of header(), which a caller that sized the memory with
+//      header().size() + terse_size() has already composed.
+//  std::string header()
+//  std::span<std::uint8_t const> compressed_frame(std::size_t pos)
+//      The bytes that write() writes: header() precedes the frames and holds the XML element and the metadata, and
+//      compressed_frame() is the compressed data of a frame. Together they allow Terse data to be transferred without
+//      copying the frames into one block, e.g. with scatter-gather I/O.
 //  void shrink_to_fit() noexcept
 //      Releases unused buffer storage to heap memory. This increases available heap memory when Terse objects were constructed
 //      from uncompressed data sources held in memory. If compression is performed concurrently, also waits for all compression
@@ -186,6 +235,13 @@
 //      Sets / overwrites any optional metadata that are associated with the specified frame. Metadata are not compressed.
 //      Metadata will be written to, and read from a stream as part of the Terse object.
 //
+// Terse_view<C>(std::span<std::uint8_t const> memory)
+//      A read-only view of Terse data held in memory, e.g. written by write(std::uint8_t*). Frames are unpacked directly
+//      from the memory by prolix(iterator, pos) or prolix(container), without copying the compressed data. The memory
+//      must remain valid while the view is used. file_size() gives the offset of any Terse data that follow.
+// Terse_view<C>(std::span<std::uint8_t const> header, std::span<std::span<std::uint8_t const> const> frames)
+//      As above, for a header() and compressed frames that are held in separate blocks of memory.
+//
 // Example:
 //
 //    std::vector<int> numbers(1000);                   // Uncompressed data location
@@ -300,6 +356,7 @@ concept Container = requires(T& c) {
  */
 
 class Concurrent;
+template <typename T> class Awaitable;
 
 /**
  * @enum Terse_mode
@@ -331,6 +388,8 @@ enum class Terse_mode {
     Default
 };
 
+template <typename CONCURRENT> class Terse_view;
+
 template<typename CONCURRENT = void>
 class Terse {
     static_assert(std::is_same_v<CONCURRENT, void> || std::is_same_v<CONCURRENT, Concurrent>, "Terse is either Concurrent or not");
@@ -339,6 +398,7 @@ class Terse {
 #endif
     
     template <typename T> friend class Terse;
+    template <typename T> friend class Terse_view;
 
 public:
     /**
@@ -349,6 +409,54 @@ public:
      */
     Terse() noexcept {};
 
+    Terse(Terse const&) = default;
+    Terse& operator=(Terse const&) = default;
+
+    /**
+     * @brief Move-constructs a Terse object.
+     *
+     * For a Terse<Concurrent> object the move is not constant-time: it blocks until concurrent compression of the
+     * frames of 'other' has finished, because the compression tasks refer to 'other'.
+     */
+    Terse(Terse&& other) noexcept { *this = std::move(other); }
+
+    /**
+     * @brief Move-assigns a Terse object.
+     *
+     * For a Terse<Concurrent> object the move is not constant-time: frames of this object that are still being
+     * compressed are discarded (see cancel()), and it blocks until concurrent compression of the frames of 'other' has
+     * finished, because the compression tasks refer to 'other'.
+     */
+    Terse& operator=(Terse&& other) noexcept {
+        if (this == &other)
+            return *this;
+        if constexpr (std::is_same_v<CONCURRENT, Concurrent>) {
+            cancel();
+            other.shrink_to_fit();
+            d_concurrent = Concurrent(other.dop());
+        }
+        d_terse_frames = std::move(other.d_terse_frames);
+        d_signed = other.d_signed;
+        d_small = other.d_small;
+        d_block = other.d_block;
+        d_size = other.d_size;
+        d_prolix_bits = other.d_prolix_bits;
+        d_binary_precision = other.d_binary_precision;
+        d_dim = std::move(other.d_dim);
+        d_metadata = std::move(other.d_metadata);
+        other.d_terse_frames.clear();
+        other.d_metadata.clear();
+        return *this;
+    }
+
+    /**
+     * @brief Destroys the Terse object. Frames that are still being compressed concurrently are discarded (see cancel()).
+     */
+    ~Terse() {
+        if constexpr (std::is_same_v<CONCURRENT, Concurrent>)
+            cancel();
+    }
+
     /**
      * @brief Creates a Terse object from data (which can be a std::vector, Field, etc.).
      * Only containers of integral types are allowed. If the container has a member function dim(),
@@ -424,43 +532,91 @@ public:
      */
     template <Container C>
     void insert(std::size_t const pos, C&& data, Terse_mode mode = Terse_mode::Default) {
-        bool dim_ok = true;
-        if constexpr (requires(C& c) { c.dim(); }) {
-            for (std::size_t i = 0; i != data.dim().size(); ++i)
-                if (number_of_frames() == 0)
-                    d_dim.push_back(static_cast<std::size_t>(data.dim()[i]));
-                else
-                    dim_ok = dim_ok && d_dim[i] == static_cast<std::size_t>(data.dim()[i]);
-        }
-        else if constexpr(requires (C &c) {c.request().shape;}) {
-            auto shape = data.request().shape;
-            if (number_of_frames() == 0)
-                d_dim = std::vector<std::size_t>(shape.begin(), shape.end());
-            else
-                dim_ok = dim_ok && d_dim == std::vector<std::size_t>(shape.begin(), shape.end());
-        }
-        if (!dim_ok)
-            throw(std::invalid_argument("The provided container and the requested frame have different dimensions"));
-        using T = std::remove_cv_t<std::remove_reference_t<decltype(*data.data())>>;
-        if (std::is_signed_v<T>)
-            mode = Terse_mode::Signed;
-        d_prolix_bits = std::max(d_prolix_bits, 8 * static_cast<unsigned>(sizeof(T)));
-        if (number_of_frames() == 0) {
-            d_size = data.size();
-            d_signed = std::is_signed_v<T>;
-        }
-        d_metadata.insert(d_metadata.begin() + static_cast<std::ptrdiff_t>(pos), "");
+        insert(pos, std::forward<C>(data), mode, [] {});
+    }
+
+    /**
+     * @brief Inserts a frame into the Terse object, as insert(pos, data, mode), and calls 'on_released' as soon as
+     * the input data are no longer referenced by the Terse object.
+     *
+     * This allows acquisition buffers to be recycled as soon as their frame has been compressed, rather than after
+     * shrink_to_fit() has waited for all frames. For example, a Terse<Concurrent> object that is given a std::span of a
+     * DMA buffer as an r-value compresses the frame in the background, and calls 'on_released' from the worker thread
+     * once compression of that frame has finished. If compression is not performed in the background, 'on_released'
+     * is called before insert() returns. If the compression task is discarded by cancel() before it runs, 'on_released'
+     * is called when the task is destroyed. The callback must not throw.
+     *
+     * @tparam C The type of the container containing integral data.
+     * @tparam F The type of the callback, which is invoked without arguments.
+     * @param pos The location where the data need to be inserted.
+     * @param data The container containing integral data.
+     * @param on_released The callback signalling that the input data are no longer referenced.
+     * @throws std::invalid_argument If the dimensions of this Terse object and the provided frame  differ.
+     */
+    template <Container C, std::invocable F>
+    void insert(std::size_t const pos, C&& data, Terse_mode mode, F&& on_released) {
+        mode = f_insert_frame_info(pos, data, mode);
         auto at = d_terse_frames.begin() + static_cast<std::ptrdiff_t>(pos);
-        if constexpr (std::is_lvalue_reference_v<C&&>)
-            d_terse_frames.insert(at, f_compress(mode, data.data()));
+        if constexpr (std::is_lvalue_reference_v<C&&>) {
+            d_terse_frames.insert(at, f_frame(*f_compress(mode, data.data())));
+            on_released();
+        }
         else if constexpr (std::is_same_v<CONCURRENT, Concurrent>)
-            d_terse_frames.insert(at, d_concurrent->background([this, d = std::move(data), mode] { return f_compress(mode, d.data()); }));
+            d_terse_frames.insert(at, d_concurrent->background([this, guard = c_Released_guard<std::remove_cvref_t<C>, F>(std::move(data), std::forward<F>(on_released)), mode]() mutable {
+                auto compressed = f_compress(mode, guard.data().data());
+                guard.release();
+                if (!compressed) // Stopped by cancel(): reported like a task that was removed from the queue
+                    throw std::future_error(std::future_errc::broken_promise);
+                return std::move(*compressed);
+            }));
         else {
-            d_terse_frames.insert(at, f_compress(mode, data.data()));
-            auto local_data = std::move(data);
+            d_terse_frames.insert(at, f_frame(*f_compress(mode, data.data())));
+            { auto local_data = std::move(data); }
+            on_released();
         }
     }
 
+    /**
+     * @brief Inserts a frame into a Terse<Concurrent> object and compresses it in the background, returning an object that
+     * can be awaited in a C++20 coroutine.
+     *
+     * The frame is inserted immediately, so the order of frames is the same as with insert(). The container is consumed
+     * if passed as an r-value; otherwise it must remain valid and unchanged until the returned Awaitable has completed.
+     * `co_await` suspends the coroutine without blocking the calling thread, and resumes it on the worker thread that
+     * finished compressing the frame. If the frame is discarded by cancel(), `co_await` rethrows a std::future_error
+     * with std::future_errc::broken_promise.
+     *
+     * @tparam C The type of the container containing integral data.
+     * @param pos The location where the data need to be inserted.
+     * @param data The container containing integral data.
+     * @return An Awaitable<void> that completes when the frame has been compressed.
+     * @throws std::invalid_argument If the dimensions of this Terse object and the provided frame differ.
+     */
+    template <Container C> requires std::is_same_v<CONCURRENT, Concurrent>
+    Awaitable<void> insert_async(std::size_t const pos, C&& data, Terse_mode mode = Terse_mode::Default) {
+        mode = f_insert_frame_info(pos, data, mode);
+        auto compressed = std::make_shared<std::promise<std::vector<std::uint8_t>>>();
+        d_terse_frames.insert(d_terse_frames.begin() + static_cast<std::ptrdiff_t>(pos), compressed->get_future());
+        if constexpr (std::is_lvalue_reference_v<C&&>)
+            return d_concurrent->awaitable([this, compressed, d = data.data(), mode] { f_set_compressed(*compressed, f_compress(mode, d)); });
+        else
+            return d_concurrent->awaitable([this, compressed, d = std::move(data), mode] { f_set_compressed(*compressed, f_compress(mode, d.data())); });
+    }
+
+    /**
+     * @brief Appends a frame to a Terse<Concurrent> object and compresses it in the background, returning an object that
+     * can be awaited in a C++20 coroutine. See insert_async().
+     *
+     * @tparam C The type of the container containing integral data.
+     * @param data The container containing integral data.
+     * @return An Awaitable<void> that completes when the frame has been compressed.
+     */
+    template <Container C> requires std::is_same_v<CONCURRENT, Concurrent>
+    Awaitable<void> push_back_async(C&& data, Terse_mode mode = Terse_mode::Default) {
+        return insert_async(number_of_frames(), std::forward<C>(data), mode);
+    }
+
+
     /**
      * @brief Insert a (potentially multiframe) Terse object at the specified position.
      * The size and dimensions of both Terse objects must be the same as that of the first frame that was used
@@ -493,18 +649,9 @@ public:
         d_metadata.insert(d_metadata.begin() + pos, trs.d_metadata.begin(), trs.d_metadata.end());
         shrink_to_fit();
         trs.shrink_to_fit();
-        if constexpr (std::is_same_v<T, void>)
-            d_terse_frames.insert(d_terse_frames.begin() + pos, trs.d_terse_frames.begin(), trs.d_terse_frames.end());
-        else {
-            std::size_t i_end = trs.d_terse_frames.size();
-            for (size_t i = 0; i < i_end; ++i) {
-                auto& frame = trs.d_terse_frames[i];
-                if (std::holds_alternative<std::vector<uint8_t>>(frame))
-                    d_terse_frames.insert(d_terse_frames.begin() + pos + i, std::get<std::vector<uint8_t>>(frame));
-                else
-                    d_terse_frames.insert(d_terse_frames.begin() + pos + i, std::get<std::future<std::vector<uint8_t>>>(frame).get());
-            }
-        }
+        std::size_t i_end = trs.d_terse_frames.size();
+        for (size_t i = 0; i < i_end; ++i) // The frames are shared, not copied
+            d_terse_frames.insert(d_terse_frames.begin() + pos + static_cast<std::ptrdiff_t>(i), trs.f_shared_frame(i));
     }
 
     /**
@@ -536,6 +683,20 @@ public:
         insert(number_of_frames(), std::forward<C>(data), mode);
     }
 
+    /**
+     * @brief Appends a frame to the Terse object, as push_back(data, mode), and calls 'on_released' as soon as
+     * the input data are no longer referenced by the Terse object. See insert(pos, data, mode, on_released).
+     *
+     * @tparam C The type of the container containing integral data.
+     * @tparam F The type of the callback, which is invoked without arguments.
+     * @param data The container containing integral data.
+     * @param on_released The callback signalling that the input data are no longer referenced.
+     */
+    template <Container C, std::invocable F>
+    void push_back(C&& data, Terse_mode mode, F&& on_released) {
+        insert(number_of_frames(), std::forward<C>(data), mode, std::forward<F>(on_released));
+    }
+
     /**
      * @brief Appends a (potentially multiframe) Terse object.
      * The size and dimensions of bothe Terse objects must be the same as that of the first frame that was used
@@ -549,18 +710,96 @@ public:
     void push_back(Terse<T>& trs) noexcept { insert(static_cast<std::ptrdiff_t>(number_of_frames()), trs); }
 
     /**
-     * @brief Removes one of the frames from the Terse object. Also waits until concurrent compression has finished, and release unused storage to the heap.
+     * @brief Appends frames of Terse data held in memory, copying their compressed bytes without unpacking them.
+     * The size, dimensions, signedness and block size of the frames must be the same as those of this Terse object,
+     * unless it is empty.
+     *
+     * @tparam T Either void or Concurrent.
+     * @param view The Terse data in memory.
+     * @param first The index of the first frame of 'view' to append.
+     * @param count The number of frames to append (by default all frames from 'first' onwards).
+     * @throws std::out_of_range If the frames are not frames of 'view'.
+     * @throws std::invalid_argument If the frames differ in signedness, size, block size or dimensions from this Terse object.
+     */
+    template <typename T>
+    void push_back(Terse_view<T> const& view, std::size_t const first = 0, std::size_t count = ~std::size_t(0)) {
+        f_push_back(view, first, count, [](std::span<std::uint8_t const> const frame) {
+            return f_frame(std::vector<std::uint8_t>(frame.begin(), frame.end()));
+        });
+    }
+
+    /**
+     * @brief Appends all frames of Terse data held in memory that is owned by 'memory', such as a memory-mapped file,
+     * without copying them on the calling thread.
+     *
+     * If 'lazy' is true, the compressed bytes of a frame are copied when the frame is first used, e.g. by prolix(), so
+     * that appending is instant however large the data are; frames that are never used are never read. Otherwise all
+     * frames are copied in parallel in the background, as frames are compressed by insert(). 'memory' is released
+     * when all frames have been copied or erased. Writing the Terse object, terse_size() and header() use all frames,
+     * and therefore copy all of them.
+     *
+     * @tparam T Either void or Concurrent.
+     * @param view The Terse data in memory.
+     * @param memory The owner of the memory of 'view'. The memory must not change while frames remain to be copied.
+     * @param lazy Whether frames are copied when first used, rather than straight away in the background.
+     * @throws std::invalid_argument If the frames differ in signedness, size, block size or dimensions from this Terse object.
+     */
+    template <typename T> requires std::is_same_v<CONCURRENT, Concurrent>
+    void push_back(Terse_view<T> const& view, std::shared_ptr<void const> const& memory, bool const lazy = true) {
+        f_push_back(view, 0, view.number_of_frames(), [this, &memory, lazy](std::span<std::uint8_t const> const frame) {
+            auto copy = [memory, frame] { return std::vector<std::uint8_t>(frame.begin(), frame.end()); };
+            return lazy ? std::async(std::launch::deferred, std::move(copy)) : d_concurrent->background(std::move(copy));
+        });
+    }
+
+    /**
+     * @brief Removes one of the frames from the Terse object. Does not wait for concurrent compression of any frame: if the
+     * removed frame is still being compressed, the result is discarded when it becomes available. The compressed data
+     * remain valid for the holders of shared_frame().
      *
      * @param i The index of the frame to be removed.
     */
     void erase(std::ptrdiff_t i) noexcept {
-        shrink_to_fit();
         d_metadata.erase(d_metadata.begin() + i);
         d_terse_frames.erase(d_terse_frames.begin() + i);
     }
+
+    /**
+     * @brief Discards all frames of a Terse<Concurrent> object whose compression has not finished.
+     *
+     * Compression tasks that are still queued are removed from the thread pool, and compression that is in progress
+     * stops at the next data block. Only frames that were completely compressed are kept, together with their metadata.
+     * This makes aborting a large concurrent compression return almost immediately, freeing the cores. The Terse object
+     * remains usable: frames inserted afterwards are compressed as usual. Frames that are loaded when they are first
+     * used (see push_back(view, memory, lazy)) are kept.
+     *
+     * @return The number of frames that were discarded.
+     */
+    std::size_t cancel() noexcept requires std::is_same_v<CONCURRENT, Concurrent> {
+        d_stop.request_stop();
+        d_concurrent->cancel();
+        d_concurrent->finish();
+        std::size_t discarded = 0;
+        for (std::size_t i = d_terse_frames.size(); i-- != 0; ) {
+            bool complete = true;
+            if (f_deferred(i))
+                continue;
+            if (std::holds_alternative<std::future<std::vector<std::uint8_t>>>(d_terse_frames[i])) {
+                try { d_terse_frames[i] = f_frame(std::get<std::future<std::vector<std::uint8_t>>>(d_terse_frames[i]).get()); }
+                catch (...) { complete = false; }
+            }
+            if (!complete) {
+                d_terse_frames.erase(d_terse_frames.begin() + static_cast<std::ptrdiff_t>(i));
+                d_metadata.erase(d_metadata.begin() + static_cast<std::ptrdiff_t>(i));
+                ++discarded;
+            }
+        }
+        d_stop = std::stop_source();
+        return discarded;
+    }
     
     /**
-     * @brief Returns a selected frame as a Terse object.
+     * @brief Returns a selected frame as a Terse object, which shares the compressed data of the frame.
      *
      * @param pos The index of the selected frame.
      * @throws std::out_of_range If the provided frame index is greater than or equal to the number of frames.
@@ -574,7 +813,7 @@ public:
         result.d_prolix_bits = d_prolix_bits;
         result.d_dim = d_dim;
         result.d_metadata.push_back(d_metadata[pos]);
-        result.d_terse_frames.push_back(f_get_frame(pos));
+        result.d_terse_frames.push_back(f_shared_frame(pos));
         return result;
     }
 
@@ -665,6 +904,40 @@ public:
         return std::forward<C>(container);
     }
     
+    /**
+     * @brief Unpacks the consecutive frames 'first' up to (but excluding) 'last', storing them one after another from
+     * the location defined by 'begin'. A Terse<Concurrent> object unpacks the frames in parallel.
+     *
+     * @tparam Iterator The type of the random access iterator or pointer.
+     * @param begin The starting iterator or pointer where the data will be stored.
+     * @param first The index of the first frame to unpack.
+     * @param last The index one past the last frame to unpack.
+     * @throws std::out_of_range If the frames are not frames of the Terse object.
+     * @throws std::invalid_argument If the iterator refers unsigned values, when the Terse object contains signed values.
+     */
+    template <typename Iterator> requires requires (Iterator& i) {*i; i + 1;}
+    void prolix(Iterator const begin, std::size_t const first, std::size_t const last) {
+        if (first > last || last > number_of_frames()) throw std::out_of_range("Frame index is out of range.");
+        f_prolix_frames(begin, last - first, [first](std::size_t const k) { return first + k; });
+    }
+
+    /**
+     * @brief Unpacks the frames with the listed indices, in the order listed, one after another from the location
+     * defined by 'begin'. A Terse<Concurrent> object unpacks the frames in parallel.
+     *
+     * @tparam Iterator The type of the random access iterator or pointer.
+     * @param begin The starting iterator or pointer where the data will be stored.
+     * @param frames The indices of the frames to unpack, which may repeat.
+     * @throws std::out_of_range If any of the indices is not that of a frame of the Terse object.
+     * @throws std::invalid_argument If the iterator refers unsigned values, when the Terse object contains signed values.
+     */
+    template <typename Iterator> requires requires (Iterator& i) {*i; i + 1;}
+    void prolix(Iterator const begin, std::span<std::size_t const> const frames) {
+        for (auto const frame : frames)
+            if (frame >= number_of_frames()) throw std::out_of_range("Frame index is out of range.");
+        f_prolix_frames(begin, frames.size(), [frames](std::size_t const k) { return frames[k]; });
+    }
+
     /**
      * @brief Unpacks the Terse data, storing the unpacked data from the location defined by 'begin'.
      *
@@ -679,23 +952,31 @@ public:
     template <typename Iterator> requires requires (Iterator& i) {*i;}
     void prolix(Iterator begin, std::size_t frame = 0) {
         if (frame >= number_of_frames()) throw std::out_of_range("Frame index is out of range.");
-        if (is_signed() && std::unsigned_integral<typename std::iterator_traits<Iterator>::value_type>)
-            throw std::invalid_argument("Cannot decompress signed data into an unsigned container.");
-        switch (d_block) {
-            case(8)  : return f_prolix<8> (begin, frame);
-            case(9)  : return f_prolix<9> (begin, frame);
-            case(10) : return f_prolix<10> (begin, frame);
-            case(11) : return f_prolix<11> (begin, frame);
-            case(12) : return f_prolix<12> (begin, frame);
-            case(13) : return f_prolix<13> (begin, frame);
-            case(14) : return f_prolix<14> (begin, frame);
-            case(15) : return f_prolix<15> (begin, frame);
-            case(16) : return f_prolix<16> (begin, frame);
-            case(20) : return f_prolix<20> (begin, frame);
-            case(24) : return f_prolix<24> (begin, frame);
-            case(32) : return f_prolix<32> (begin, frame);
-            default  : return f_prolix<0> (begin, frame);
-        }
+        f_prolix(begin, std::span<std::uint8_t const>(f_get_frame(frame)));
+    }
+
+    /**
+     * @brief Unpacks a frame of a Terse<Concurrent> object in the background, returning an object that can be awaited
+     * in a C++20 coroutine.
+     *
+     * The destination is either a container or an iterator, as for prolix(). A container passed as an l-value must
+     * remain valid until the returned Awaitable has completed. `co_await` suspends the coroutine without blocking the
+     * calling thread, and resumes it on the worker thread that unpacked the frame. Exceptions thrown by prolix() are
+     * rethrown by `co_await`.
+     *
+     * @tparam D The type of the destination container or iterator.
+     * @param destination The container or iterator where the data will be stored.
+     * @param frame The index of the frame to unpack (default is 0).
+     * @return An Awaitable<void> that completes when the frame has been unpacked.
+     * @throws std::out_of_range If the provided frame index is greater than or equal to the number of frames.
+     */
+    template <typename D> requires std::is_same_v<CONCURRENT, Concurrent>
+    Awaitable<void> prolix_async(D&& destination, std::size_t const frame = 0) {
+        if (frame >= number_of_frames()) throw std::out_of_range("Frame index is out of range.");
+        if constexpr (std::is_lvalue_reference_v<D&&>)
+            return d_concurrent->awaitable([this, &destination, frame] { prolix(destination, frame); });
+        else
+            return d_concurrent->awaitable([this, d = std::move(destination), frame]() mutable { prolix(d, frame); });
     }
 
     /**
@@ -809,7 +1090,7 @@ public:
      *
      * @return True  if the frame with the specified index has floating point values
      */
-    bool is_float(std::size_t frame_num) { return (Bitqueue_pop(f_get_frame(frame_num)).pop<18, std::size_t>() == 0b111111111111111010); }
+    bool is_float(std::size_t frame_num) { return f_is_float(f_get_frame(frame_num)); }
     
     /**
      * @brief Returns if the default mode of compression for unsigned data is set to Terse_mode::Small_unsigned.
@@ -877,9 +1158,7 @@ public:
     std::size_t file_size() noexcept {
         if (number_of_frames() == 0)
             return 0;
-        std::ostringstream oss;
-        f_write_metadata(oss);
-        return oss.str().size() + terse_size();
+        return f_header().size() + terse_size();
     }
     
      /**
@@ -898,14 +1177,91 @@ public:
         ostream.flush();
     }
     
+    /**
+     * @brief Write the Terse object to a contiguous block of memory.
+     *
+     * The memory receives exactly the bytes that write(std::ostream&) would produce, but without the overhead of a stream:
+     * the header and the compressed frames are copied directly into place. The memory must hold at least file_size() bytes.
+     *
+     * @param destination Pointer to the first byte of the memory block.
+     * @return The number of bytes written.
+     */
+    std::size_t write(std::uint8_t* destination) {
+        if (number_of_frames() == 0) return 0;
+        return write(destination, f_header());
+    }
+
+    /**
+     * @brief Write the Terse object to a contiguous block of memory, with a header that was composed before.
+     *
+     * Composing the header lists the sizes of all frames; a caller that needs the size of the memory first can compose
+     * it once with header(), and pass it here. The Terse object must not be modified in between.
+     *
+     * @param destination Pointer to the first byte of the memory block, of at least header.size() + terse_size() bytes.
+     * @param header The result of header().
+     * @return The number of bytes written.
+     */
+    std::size_t write(std::uint8_t* destination, std::string_view const header) {
+        if (number_of_frames() == 0) return 0;
+        std::memcpy(destination, header.data(), header.size());
+        std::size_t written = header.size();
+        for (std::size_t i = 0; i!= d_terse_frames.size(); ++i) {
+            auto const& frame = f_get_frame(i);
+            std::memcpy(destination + written, frame.data(), frame.size());
+            written += frame.size();
+        }
+        return written;
+    }
+
+    /**
+     * @brief Returns the bytes that write() writes before the compressed frames: the XML element with the parameters
+     * of the Terse object, followed by the metadata.
+     */
+    std::string header() {
+        return f_header();
+    }
+
+    /**
+     * @brief Returns the compressed data of a frame, as written by write(). If the frame is being compressed
+     * concurrently, waits until compression has finished. The memory remains valid until the frame is erased, or
+     * shrink_to_fit() is called.
+     *
+     * @param pos The index of the frame.
+     * @throws std::out_of_range If the provided frame index is greater than or equal to the number of frames.
+     */
+    std::span<std::uint8_t const> compressed_frame(std::size_t const pos) {
+        if (pos >= number_of_frames()) throw std::out_of_range("Frame index is out of range.");
+        return f_get_frame(pos);
+    }
+
+    /**
+     * @brief Returns shared ownership of the compressed data of a frame, as written by write(), without copying them.
+     * If the frame is being compressed concurrently, waits until compression has finished. The data never change, and
+     * remain valid after the frame is erased, shrink_to_fit() is called or the Terse object is destroyed.
+     *
+     * @param pos The index of the frame.
+     * @throws std::out_of_range If the provided frame index is greater than or equal to the number of frames.
+     */
+    std::shared_ptr<std::vector<std::uint8_t> const> shared_frame(std::size_t const pos) {
+        if (pos >= number_of_frames()) throw std::out_of_range("Frame index is out of range.");
+        return f_shared_frame(pos);
+    }
+    
     /**
      * @brief Releases unused buffer storage to heap memory. This increases available heap memory when Terse objects were constructed
      * from uncompressed data sources held in memory. If compression is performed concurrently, also waits for all compression
-     * processes to finish. It has no effect when Terse object are read from a stream.
+     * processes to finish. It has no effect when Terse object are read from a stream. Frames that are loaded when they
+     * are first used (see push_back(view, memory, lazy)) are left alone. Frames that are shared (see shared_frame()) are
+     * replaced by a trimmed copy, and the shared data are released to their other holders.
      */
     void shrink_to_fit() noexcept {
-        for (std::size_t i = 0; i!= d_terse_frames.size(); ++i)
-            f_get_frame(i).shrink_to_fit();
+        for (std::size_t i = 0; i!= d_terse_frames.size(); ++i) {
+            if (f_deferred(i)) continue;
+            auto& frame = f_shared_frame(i);
+            if (frame->capacity() == frame->size()) continue;
+            if (frame.use_count() == 1) frame->shrink_to_fit();
+            else frame = f_frame(std::vector<std::uint8_t>(frame->begin(), frame->end()));
+        }
     }
     
     /**
@@ -937,13 +1293,39 @@ public:
     }
     
 private:
+    // The compressed data of a frame are shared with shared_frame() and with other Terse objects (at(), insert()), and
+    // are only modified before they are shared, while a frame is read or trimmed by shrink_to_fit().
+    using Frame = std::shared_ptr<std::vector<std::uint8_t>>;
     using FrameStorage = std::conditional_t<
         std::is_same_v<CONCURRENT, Concurrent>,
-        std::vector<std::variant<std::future<std::vector<std::uint8_t>>, std::vector<std::uint8_t>>>,
-        std::vector<std::vector<std::uint8_t>>>;
+        std::vector<std::variant<std::future<std::vector<std::uint8_t>>, Frame>>,
+        std::vector<Frame>>;
+
+    // Owns the input data of a frame that is compressed in the background, and calls 'on_released' once the data are
+    // released: after compression, or when the task is discarded without running (cancel(), destruction of the pool).
+    template <typename D, typename F>
+    class c_Released_guard {
+    public:
+        c_Released_guard(D&& data, F&& on_released) : d_data(std::move(data)), d_on_released(std::forward<F>(on_released)) {}
+        c_Released_guard(c_Released_guard&& other) :
+            d_data(std::move(other.d_data)), d_on_released(std::move(other.d_on_released)), d_pending(std::exchange(other.d_pending, false)) {}
+        c_Released_guard& operator=(c_Released_guard&&) = delete;
+        ~c_Released_guard() { release(); }
+        D const& data() const noexcept { return d_data; }
+        void release() noexcept {
+            if (std::exchange(d_pending, false)) {
+                { auto local_data = std::move(d_data); }
+                d_on_released();
+            }
+        }
+    private:
+        D d_data;
+        std::decay_t<F> d_on_released;
+        bool d_pending = true;
+    };
 
     FrameStorage d_terse_frames;
-    bool d_signed;
+    bool d_signed = false;
     bool d_small = true;
     std::size_t d_block = 12;
     std::size_t d_size = 0;
@@ -955,6 +1337,10 @@ private:
         if constexpr (std::is_same_v<CONCURRENT, Concurrent>) return Concurrent(1);
         else return std::nullopt;
     }();
+    std::stop_source d_stop = []() -> std::stop_source {
+        if constexpr (std::is_same_v<CONCURRENT, Concurrent>) return std::stop_source();
+        else return std::stop_source(std::nostopstate);
+    }();
     
     template <typename STREAM> requires std::derived_from<STREAM, std::istream>
     Terse(STREAM& istream, XML_element const& xmle) {
@@ -972,27 +1358,65 @@ private:
                 unsigned int val;
                 while (meta_str >> val) {
                     d_metadata.push_back(std::string(val, ' '));
-                    istream.read(reinterpret_cast<char*>(&d_metadata.back()), val);
+                    istream.read(d_metadata.back().data(), val);
                 }
             }
             d_terse_frames.resize(std::stoull(xmle.attribute("number_of_frames")));
             for (auto& frame : d_terse_frames)
-                frame = std::vector<std::uint8_t>(); // Initialize each element to an empty vector
+                frame = f_frame(std::vector<std::uint8_t>()); // Initialize each element to an empty vector
             if (xmle.attribute("memory_sizes_of_frames") == "")
                 f_fill_terse_frames(istream, std::stoul(xmle.attribute("memory_size")));
             else {
                 std::istringstream frame_sizes_str(xmle.attribute("memory_sizes_of_frames"));
                 unsigned int val;
                 for (std::size_t i = 0; i != d_terse_frames.size(); ++i) {
+                    auto& frame = *f_shared_frame(i);
                     frame_sizes_str >> val;
-                    f_get_frame(i).resize(val);
-                    istream.read(reinterpret_cast<char*>(&(f_get_frame(i)[0])), static_cast<std::ptrdiff_t>(f_get_frame(i).size()));
+                    frame.resize(val);
+                    istream.read(reinterpret_cast<char*>(frame.data()), static_cast<std::ptrdiff_t>(frame.size()));
                 }
             }
         }
     }
     
+    template <Container C>
+    Terse_mode f_insert_frame_info(std::size_t const pos, C& data, Terse_mode mode) {
+        bool dim_ok = true;
+        if constexpr (requires(C& c) { c.dim(); }) {
+            if (number_of_frames() == 0) d_dim.clear();
+            for (std::size_t i = 0; i != data.dim().size(); ++i)
+                if (number_of_frames() == 0)
+                    d_dim.push_back(static_cast<std::size_t>(data.dim()[i]));
+                else
+                    dim_ok = dim_ok && d_dim[i] == static_cast<std::size_t>(data.dim()[i]);
+        }
+        else if constexpr(requires (C &c) {c.request().shape;}) {
+            auto shape = data.request().shape;
+            if (number_of_frames() == 0)
+                d_dim = std::vector<std::size_t>(shape.begin(), shape.end());
+            else
+                dim_ok = dim_ok && d_dim == std::vector<std::size_t>(shape.begin(), shape.end());
+        }
+        if (!dim_ok)
+            throw(std::invalid_argument("The provided container and the requested frame have different dimensions"));
+        using T = std::remove_cv_t<std::remove_reference_t<decltype(*data.data())>>;
+        if (std::is_signed_v<T>)
+            mode = Terse_mode::Signed;
+        d_prolix_bits = std::max(d_prolix_bits, 8 * static_cast<unsigned>(sizeof(T)));
+        if (number_of_frames() == 0) {
+            d_size = data.size();
+            d_signed = std::is_signed_v<T>;
+        }
+        d_metadata.insert(d_metadata.begin() + static_cast<std::ptrdiff_t>(pos), "");
+        return mode;
+    }
+
     void f_write_metadata(std::ostream& ostream) {
+        ostream << f_header();
+        ostream.flush();
+    }
+
+    std::string f_header() {
         std::size_t memory_size = terse_size();
         XML_element xml("<Terse/>");
         xml.add_attribute("prolix_bits", d_prolix_bits);
@@ -1012,21 +1436,105 @@ private:
                 metadata_sizes.push_back(d_metadata[i].size());
             xml.add_attribute("metadata_string_sizes", metadata_sizes);
         }
-        ostream << xml.XML();
-        for (auto& str : d_metadata) ostream << str;
-        ostream.flush();
+        std::string header = xml.XML();
+        for (auto& str : d_metadata) header += str;
+        return header;
+    }
+
+    static bool f_is_float(std::span<std::uint8_t const> const terse_frame) noexcept {
+        return Bitqueue_pop(terse_frame).pop<18, std::size_t>() == 0b111111111111111010;
     }
 
-    std::vector<std::uint8_t>& f_get_frame(std::size_t index) noexcept {
+    // Appends 'count' frames of 'view' from 'first', where 'make_frame' returns the stored frame for the memory of a frame.
+    template <typename T, typename F>
+    void f_push_back(Terse_view<T> const& view, std::size_t const first, std::size_t count, F const make_frame) {
+        if (first > view.number_of_frames()) throw std::out_of_range("Frame index is out of range.");
+        count = std::min(count, view.number_of_frames() - first);
+        Terse<T> const& trs = view.d_terse;
+        if (number_of_frames() == 0) {
+            d_signed = trs.d_signed;
+            d_block = trs.d_block;
+            d_size = trs.d_size;
+            d_dim = trs.d_dim;
+        }
+        if (trs.d_dim != d_dim)
+            throw(std::invalid_argument("Dimension mismatch of the provided Terse data"));
+        if (trs.d_signed != d_signed)
+            throw(std::invalid_argument("Sign mismatch of the provided Terse data"));
+        if (trs.d_block != d_block)
+            throw(std::invalid_argument("Blocksize mismatch of the provided Terse data"));
+        if (trs.d_size != d_size)
+            throw(std::invalid_argument("Size mismatch of the provided Terse data"));
+        d_prolix_bits = std::max(d_prolix_bits, trs.d_prolix_bits);
+        for (std::size_t i = first; i != first + count; ++i) {
+            d_metadata.emplace_back(view.metadata(i));
+            d_terse_frames.emplace_back(make_frame(view.d_frames[i]));
+        }
+    }
+
+
+    // True if the frame is loaded when it is first used, see push_back(view, memory, lazy).
+    bool f_deferred(std::size_t const index) const noexcept {
+        if constexpr (std::is_same_v<CONCURRENT, void>)
+            return false;
+        else {
+            auto const* frame = std::get_if<std::future<std::vector<std::uint8_t>>>(&d_terse_frames[index]);
+            return frame && frame->wait_for(std::chrono::seconds(0)) == std::future_status::deferred;
+        }
+    }
+
+    static Frame f_frame(std::vector<std::uint8_t>&& bytes) {
+        return std::make_shared<std::vector<std::uint8_t>>(std::move(bytes));
+    }
+
+    Frame& f_shared_frame(std::size_t index) noexcept {
         if constexpr (std::is_same_v<CONCURRENT, void>)
             return d_terse_frames[index];
         else {
             if (std::holds_alternative<std::future<std::vector<std::uint8_t>>>(d_terse_frames[index]))
-                d_terse_frames[index] = std::get<std::future<std::vector<std::uint8_t>>>(d_terse_frames[index]).get();
-            return std::get<std::vector<std::uint8_t>>(d_terse_frames[index]);
+                d_terse_frames[index] = f_frame(std::get<std::future<std::vector<std::uint8_t>>>(d_terse_frames[index]).get());
+            return std::get<Frame>(d_terse_frames[index]);
+        }
+    }
+
+    std::vector<std::uint8_t> const& f_get_frame(std::size_t index) noexcept { return *f_shared_frame(index); }
+
+    // Unpacks 'count' frames one after another from 'begin', where 'frame(k)' is the index of the k-th frame. Frames that are
+    // still being compressed are waited for on this thread first, so that the unpacking tasks never wait for each other.
+    template <typename Iterator, typename F>
+    void f_prolix_frames(Iterator const begin, std::size_t const count, F const frame) {
+        if constexpr (std::is_same_v<CONCURRENT, void>)
+            for (std::size_t k = 0; k != count; ++k)
+                prolix(begin + k * size(), frame(k));
+        else {
+            for (std::size_t k = 0; k != count; ++k)
+                f_get_frame(frame(k));
+            std::vector<std::future<void>> futures;
+            for (std::size_t k = 0; k != count; ++k)
+                futures.push_back(d_concurrent->background([this, begin, &frame, k] {
+                    prolix(begin + k * size(), frame(k));
+                }));
+            std::exception_ptr error;
+            for (auto& future : futures)
+                try { future.get(); }
+                catch (...) { if (!error) error = std::current_exception(); }
+            if (error) std::rethrow_exception(error);
+        }
+    }
+
+    // Fulfils the promise of a frame compressed by insert_async(). Compression that was stopped by cancel() is reported
+    // like a task that was removed from the queue, both to the frame and to the Awaitable of insert_async().
+    static void f_set_compressed(std::promise<std::vector<std::uint8_t>>& promise,
+                                 std::optional<std::vector<std::uint8_t>>&& compressed) {
+        if (!compressed) {
+            std::future_error const stopped(std::future_errc::broken_promise);
+            promise.set_exception(std::make_exception_ptr(stopped));
+            throw stopped;
         }
+        promise.set_value(std::move(*compressed));
     }
 
+    // Returns std::nullopt if compression was stopped by cancel().
     template <typename Iterator>
     auto f_compress(Terse_mode mode, Iterator const data_begin) {
         if constexpr (std::is_signed_v<std::remove_reference_t<decltype(*data_begin)>>)
@@ -1039,6 +1547,36 @@ private:
         }
     }
     
+    /**
+     * @brief Returns the 'size' values of the frame 'data' from index 'from' as a span. Values of contiguous iterators
+     * are read in place; values of other iterators, such as those of a Strided_span, are copied block by block into
+     * 'staging', which holds at least 'size' values.
+     */
+    template <typename Iterator, typename T>
+    static std::span<T const> f_data_block(Iterator const data, std::size_t const from, std::size_t const size,
+                                           Unique_array<T>& staging) noexcept {
+        if constexpr (std::contiguous_iterator<Iterator>)
+            return std::span<T const>(std::to_address(data) + from, size);
+        else {
+            std::copy_n(data + static_cast<std::ptrdiff_t>(from), size, staging.begin());
+            return std::span<T const>(staging.data(), size);
+        }
+    }
+
+    // Grows 'terse_frame' unless one more block of at most 'block_bytes' bytes fits after the current position of
+    // 'bitqueue', together with the block headers and the partially filled 8-byte word that the bitqueue flushes.
+    void f_reserve(std::vector<std::uint8_t>& terse_frame, Bitqueue_push_back& bitqueue, std::size_t const from,
+                   std::size_t const block_bytes) const {
+        std::size_t const index = static_cast<std::size_t>(bitqueue.data() - terse_frame.data());
+        std::size_t const required = index + block_bytes + 24;
+        if (required <= terse_frame.size())
+            return;
+        std::size_t terse_frame_size = from == 0 ? 0 : static_cast<std::size_t>(1.1 * terse_frame.size() * d_size / from);
+        terse_frame_size = (std::max(terse_frame_size, required + block_bytes) + 7) & ~std::size_t(7);
+        terse_frame.resize(terse_frame_size);
+        bitqueue.relocate(terse_frame.data() + index);
+    }
+
 #define PUSH_BITS(prevbits, bits) \
     if (prevbits == bits) bitqueue.push_back<1>(0b1); \
     else if (bits < 7) bitqueue.push_back<4>(bits << 1); \
@@ -1048,26 +1586,24 @@ private:
 
     template <Terse_mode MODE, typename Iterator> requires ((MODE == Terse_mode::Signed || MODE == Terse_mode::Unsigned) &&
                                                             std::integral<typename std::iterator_traits<Iterator>::value_type>)
-    std::vector<std::uint8_t> const f_compress(Iterator data) noexcept {
+    std::optional<std::vector<std::uint8_t>> f_compress(Iterator data) noexcept {
         using T = std::iterator_traits<Iterator>::value_type;
+        std::stop_token const stop = d_stop.get_token();
         std::size_t terse_frame_size = static_cast<std::size_t>(d_size * sizeof(decltype(*data)) * 0.01) + 2 * (d_block * sizeof(decltype(*data)) + 4);
         terse_frame_size = (terse_frame_size + 7) & ~std::size_t(7);
         std::vector<std::uint8_t> terse_frame(terse_frame_size);
         Unique_array<std::remove_const_t<T>> buffer(d_block);
+        Unique_array<std::remove_const_t<T>> staging(std::contiguous_iterator<Iterator> ? 0 : d_block);
         Bitqueue_push_back bitqueue(terse_frame);
         if constexpr (MODE != Terse_mode::Signed)
             bitqueue.push_back<18>(0b111111111111111000);
         std::size_t prevbits = 0;
         std::size_t prevmasked_bits = 0;
         for (std::size_t from = 0; from < d_size; from += d_block) {
-            std::size_t index = static_cast<std::size_t>(bitqueue.data() - terse_frame.data());
-            if (index > terse_frame.size() - d_block * sizeof(decltype(*data)) - 2) {
-                terse_frame_size = static_cast<std::size_t>(1.1 * terse_frame.size() * d_size / from);
-                terse_frame_size = (terse_frame_size + 7) & ~std::size_t(7);
-                terse_frame.resize(terse_frame_size);
-                bitqueue.relocate(terse_frame.data() + index);
-            }
-            std::span<T const> data_block(data + static_cast<std::ptrdiff_t>(from), std::min(d_size - from, d_block));
+            if (stop.stop_requested())
+                return std::nullopt;
+            f_reserve(terse_frame, bitqueue, from, d_block * sizeof(T));
+            std::span<T const> const data_block = f_data_block(data, from, std::min(d_size - from, d_block), staging);
             std::uint8_t significant_bits = f_most_significant_bit(data_block);
             PUSH_BITS(prevbits, significant_bits);
             if constexpr (MODE == Terse_mode::Signed)
@@ -1090,13 +1626,14 @@ private:
     }
 
     template <Terse_mode MODE, typename Iterator> requires (std::floating_point<typename std::iterator_traits<Iterator>::value_type>)
-    std::vector<std::uint8_t> const f_compress(Iterator data) noexcept {
+    std::optional<std::vector<std::uint8_t>> f_compress(Iterator data) noexcept {
         using T = std::iterator_traits<Iterator>::value_type;
+        std::stop_token const stop = d_stop.get_token();
         std::uint8_t binary_precision = std::min(d_binary_precision, static_cast<std::uint8_t>(std::numeric_limits<T>::digits +1));
         std::size_t terse_frame_size = static_cast<std::size_t>(d_size * sizeof(T) * 0.01) + 2 * (d_block * sizeof(decltype(*data)) + 4);
         terse_frame_size = (terse_frame_size + 7) & ~std::size_t(7);
         std::vector<std::uint8_t> terse_frame(terse_frame_size);
-        Unique_array<std::remove_const_t<T>> buffer(d_block);
+        Unique_array<std::remove_const_t<T>> staging(std::contiguous_iterator<Iterator> ? 0 : d_block);
         Bitqueue_push_back bitqueue(terse_frame);
         bitqueue.push_back<18>(0b111111111111111010);
         bitqueue.push_back<6>(binary_precision);
@@ -1105,14 +1642,10 @@ private:
         Unique_array<int> exponents(d_block);
         std::size_t mantissa_bits = (static_cast<std::size_t>(1) << (binary_precision - 1));
         for (std::size_t from = 0; from < d_size; from += d_block) {
-            std::size_t index = static_cast<std::size_t>(bitqueue.data() - terse_frame.data());
-            if (index > terse_frame.size() - d_block * sizeof(decltype(*data)) - 2) {
-                terse_frame_size = static_cast<std::size_t>(1.1 * terse_frame.size() * d_size / from);
-                terse_frame_size = (terse_frame_size + 7) & ~std::size_t(7);
-                terse_frame.resize(terse_frame_size);
-                bitqueue.relocate(terse_frame.data() + index);
-            }
-            std::span<T const> data_block(data + static_cast<std::ptrdiff_t>(from), std::min(d_size - from, d_block));
+            if (stop.stop_requested())
+                return std::nullopt;
+            f_reserve(terse_frame, bitqueue, from, d_block * 2 * sizeof(T));  // Mantissas and exponents
+            std::span<T const> const data_block = f_data_block(data, from, std::min(d_size - from, d_block), staging);
             bool unsigned_block = true;
             for (std::size_t i=0; i != data_block.size(); ++i) {
                 T mantissa_float = std::frexp(data_block[i], &exponents[i]);
@@ -1171,6 +1704,13 @@ private:
         previous_maxval = maxval;
     }
 
+    // Whether a block of values up to 'max' is encoded as a weak block: one number in base max + 1, which must fit in
+    // 64 bits (7^23 does not).
+    template <typename T>
+    static constexpr bool f_weak_block(T const max, std::size_t const size) noexcept {
+        return max < 6 || (max == 6 && size <= 22);
+    }
+
     template <typename T, std::size_t N>
     constexpr void f_compress_strong_block(std::span<T, N> const data_block,
                                            Bitqueue_push_back& bitqueue,
@@ -1193,29 +1733,27 @@ private:
     }
     
     template <Terse_mode MODE, typename Iterator> requires (MODE == Terse_mode::Small_unsigned)
-    std::vector<std::uint8_t> const f_compress(Iterator data) noexcept {
+    std::optional<std::vector<std::uint8_t>> f_compress(Iterator data) noexcept {
         using T = std::iterator_traits<Iterator>::value_type;
+        std::stop_token const stop = d_stop.get_token();
         static_assert(std::is_unsigned_v<T>, "Cannot compress signed data with Terse_mode::small");
         //std::size_t const block = std::min(d_block, 24ul);
         std::size_t block = std::min(d_block, std::size_t(24));
         std::size_t terse_frame_size = static_cast<std::size_t>(d_size * sizeof(decltype(*data)) * 0.01) + 2 * (d_block * sizeof(decltype(*data)) + 4);
         terse_frame_size = (terse_frame_size + 7) & ~std::size_t(7);
         std::vector<std::uint8_t> terse_frame(terse_frame_size);
+        Unique_array<std::remove_const_t<T>> staging(std::contiguous_iterator<Iterator> ? 0 : d_block);
         Bitqueue_push_back bitqueue(terse_frame);
         bitqueue.push_back<18>(0b111111111111111100);
         T prevmax = 0;
         std::size_t prevbits = 0;
         for (std::size_t from = 0; from < d_size; from += block) {
-            std::size_t index = static_cast<std::size_t>(bitqueue.data() - terse_frame.data());
-            if (index > terse_frame.size() - block * sizeof(decltype(*data)) - 2) {
-                terse_frame_size = static_cast<std::size_t>(1.1 * terse_frame.size() * d_size / from);
-                terse_frame_size = (terse_frame_size + 7) & ~std::size_t(7);
-                terse_frame.resize(terse_frame_size);
-                bitqueue.relocate(terse_frame.data() + index);
-            }
-            std::span<T const> data_block(data + static_cast<std::ptrdiff_t>(from), std::min(d_size - from, d_block));
+            if (stop.stop_requested())
+                return std::nullopt;
+            f_reserve(terse_frame, bitqueue, from, block * sizeof(T));
+            std::span<T const> const data_block = f_data_block(data, from, std::min(d_size - from, block), staging);
             T max = std::ranges::max(data_block);
-            if (max < 7) {
+            if (f_weak_block(max, data_block.size())) {
                 f_compress_weak_block(data_block, bitqueue, max, prevmax);
                 prevbits = 65;
             }
@@ -1249,25 +1787,29 @@ private:
             bitqueue.push_back<11>(0b11111100 + ((sizeof(T) * 8 - 10) << 8));
         else
             bitqueue.push_back<17>(0b11111111100 + ((sizeof(T) * 8 - 17) << 11));
-        prevmax = std::numeric_limits<T>::max();
+        prevmax = std::numeric_limits<T>::max() / 2;  // As the decoder after the header above
         prevbits = sizeof(T) * 8 + 2;
         for ( ; from < d_size; from += block) {
-            std::size_t index = static_cast<std::size_t>(bitqueue.data() - terse_frame.data());
-            if (index > terse_frame.size() - block * sizeof(decltype(*data)) - 2) {
-                terse_frame.resize(static_cast<std::size_t>(1.1 * terse_frame.size() * d_size / from));
-                bitqueue.relocate(terse_frame.data() + index);
-            }
+            f_reserve(terse_frame, bitqueue, from, block * sizeof(T));
             std::size_t to = std::min(d_size, from + block);
             std::transform(data + static_cast<std::ptrdiff_t>(from), data + static_cast<std::ptrdiff_t>(to), buffer.begin(), [](T val) {return val + 1;});
             std::span<T const> unmasked(buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(to - from));
             max = std::ranges::max(unmasked);
-            if (max < 7)
+            // The decoder continues from the maximum of each block, and tells weak from strong blocks by that maximum:
+            // a block that leaves it below 7 must be followed by a full header.
+            if (f_weak_block(max, unmasked.size())) {
                 f_compress_weak_block(unmasked, bitqueue, max, prevmax);
-            else
+                prevbits = sizeof(T) * 8 + 2;
+            }
+            else {
                 f_compress_strong_block(unmasked, bitqueue, f_most_significant_bit(max), prevbits);
+                prevmax = max;
+                if (max < 7)
+                    prevbits = sizeof(T) * 8 + 2;
+            }
             if (to != d_size) {
-                std::span test_for_masked(data + static_cast<std::ptrdiff_t>(to), std::min(d_size - to, block));
-                if (std::ranges::max(test_for_masked) != std::numeric_limits<T>::max()) {
+                auto const test_for_masked = data + static_cast<std::ptrdiff_t>(to);
+                if (*std::max_element(test_for_masked, test_for_masked + static_cast<std::ptrdiff_t>(std::min(d_size - to, block))) != std::numeric_limits<T>::max()) {
                     bitqueue.push_back<1>(0); // End masking
                     break;
                  }
@@ -1303,22 +1845,43 @@ if (bitqueue.template pop<1,uint8_t>() == 0) {          \
     }                                                   \
 }
 
+    template <typename Iterator>
+    void f_prolix(Iterator begin, std::span<std::uint8_t const> const terse_frame) {
+        if (is_signed() && std::unsigned_integral<typename std::iterator_traits<Iterator>::value_type>)
+            throw std::invalid_argument("Cannot decompress signed data into an unsigned container.");
+        switch (d_block) {
+            case(8)  : return f_prolix<8> (begin, terse_frame);
+            case(9)  : return f_prolix<9> (begin, terse_frame);
+            case(10) : return f_prolix<10> (begin, terse_frame);
+            case(11) : return f_prolix<11> (begin, terse_frame);
+            case(12) : return f_prolix<12> (begin, terse_frame);
+            case(13) : return f_prolix<13> (begin, terse_frame);
+            case(14) : return f_prolix<14> (begin, terse_frame);
+            case(15) : return f_prolix<15> (begin, terse_frame);
+            case(16) : return f_prolix<16> (begin, terse_frame);
+            case(20) : return f_prolix<20> (begin, terse_frame);
+            case(24) : return f_prolix<24> (begin, terse_frame);
+            case(32) : return f_prolix<32> (begin, terse_frame);
+            default  : return f_prolix<0> (begin, terse_frame);
+        }
+    }
+
     template <std::size_t N, typename Iterator>
-    void f_prolix(Iterator const begin, std::size_t const frame) noexcept {
-        Bitqueue_pop bitqueue(f_get_frame(frame));
+    void f_prolix(Iterator const begin, std::span<std::uint8_t const> const terse_frame) noexcept {
+        Bitqueue_pop bitqueue(terse_frame);
         std::size_t flag = bitqueue.pop<18, std::size_t>();
         switch (flag) {
-            case 0b111111111111111100: return f_prolix_small_unsigned<N>(begin, frame);
-            case 0b111111111111111000: return f_prolix_unsigned<N>(begin, frame);
-            case 0b111111111111111010: return f_prolix_float<N>(begin, frame);
-            default: return f_prolix_signed<N>(begin, frame);
+            case 0b111111111111111100: return f_prolix_small_unsigned<N>(begin, terse_frame);
+            case 0b111111111111111000: return f_prolix_unsigned<N>(begin, terse_frame);
+            case 0b111111111111111010: return f_prolix_float<N>(begin, terse_frame);
+            default: return f_prolix_signed<N>(begin, terse_frame);
         }
     }
     
     template <std::size_t N, typename Iterator>
-    void f_prolix_signed(Iterator begin, std::size_t frame) noexcept {
+    void f_prolix_signed(Iterator begin, std::span<std::uint8_t const> const terse_frame) noexcept {
         using T = std::iterator_traits<Iterator>::value_type;
-        Bitqueue_pop bitqueue(f_get_frame(frame));
+        Bitqueue_pop bitqueue(terse_frame);
         uint8_t significant_bits = 0;
         for (std::size_t from = 0; from < d_size; from += d_block) {
             auto const to = std::min(d_size, from + d_block);
@@ -1331,9 +1894,9 @@ if (bitqueue.template pop<1,uint8_t>() == 0) {          \
     }
 
     template <std::size_t N, typename Iterator> 
-    void f_prolix_float(Iterator begin, std::size_t frame) noexcept {
+    void f_prolix_float(Iterator begin, std::span<std::uint8_t const> const terse_frame) noexcept {
         using T = std::iterator_traits<Iterator>::value_type;
-        Bitqueue_pop bitqueue(f_get_frame(frame));
+        Bitqueue_pop bitqueue(terse_frame);
         bitqueue.pop<18, std::size_t>();
         std::uint8_t const binary_precision = bitqueue.pop<6, std::uint8_t>();
         std::uint8_t significant_bits_exponents = 0;
@@ -1366,9 +1929,9 @@ if (bitqueue.template pop<1,uint8_t>() == 0) {          \
     }
     
     template <std::size_t N, typename Iterator>
-    void f_prolix_unsigned(Iterator begin, std::size_t frame) noexcept {
+    void f_prolix_unsigned(Iterator begin, std::span<std::uint8_t const> const terse_frame) noexcept {
         using T = std::iterator_traits<Iterator>::value_type;
-        Bitqueue_pop bitqueue(f_get_frame(frame));
+        Bitqueue_pop bitqueue(terse_frame);
         bitqueue.pop<18, std::size_t>();
         uint8_t significant_bits = 0;
         uint8_t masked_bits = 0;
@@ -1395,12 +1958,12 @@ if (bitqueue.template pop<1,uint8_t>() == 0) {          \
 
     template <std::size_t N, typename Iterator>
     requires std::floating_point<typename std::iterator_traits<Iterator>::value_type>
-    void f_prolix_small_unsigned(Iterator begin, std::size_t frame) noexcept {
+    void f_prolix_small_unsigned(Iterator begin, std::span<std::uint8_t const> const terse_frame) noexcept {
         using F = typename std::iterator_traits<Iterator>::value_type;
         auto prolix_float = [&](auto type_tag) {
             using T = decltype(type_tag);
             std::vector<T> buffer(d_size);
-            prolix(buffer.begin(), frame);
+            f_prolix(buffer.begin(), terse_frame);
             std::transform(buffer.begin(), buffer.end(), begin, [](T val) { return static_cast<F>(val); });
         };
         if (d_prolix_bits <= 8)        prolix_float(uint8_t{});
@@ -1420,11 +1983,11 @@ if (bitqueue.template pop<1,uint8_t>() == 0) {          \
     }
     
     template <std::size_t N, typename Iterator> requires std::integral<typename std::iterator_traits<Iterator>::value_type>
-    void f_prolix_small_unsigned(Iterator begin, std::size_t frame) noexcept {
+    void f_prolix_small_unsigned(Iterator begin, std::span<std::uint8_t const> const terse_frame) noexcept {
         using T = std::iterator_traits<Iterator>::value_type;
         //std::size_t block = std::min(d_block, 24ul);
         std::size_t block = std::min(d_block, std::size_t(24));
-        Bitqueue_pop bitqueue(f_get_frame(frame));
+        Bitqueue_pop bitqueue(terse_frame);
         bitqueue.pop<18, std::size_t>();
         uint8_t bits = 0;
         T max = 0;
@@ -1436,7 +1999,7 @@ if (bitqueue.template pop<1,uint8_t>() == 0) {          \
                 case 1: POP(T, 1, begin + static_cast<std::ptrdiff_t>(from), static_cast<std::ptrdiff_t>(to - from)); break;
                 case 2: {
                     std::span<T> data_block(begin + static_cast<std::ptrdiff_t>(from), begin + static_cast<std::ptrdiff_t>(to));
-                    std::size_t val = bitqueue.pop<std::size_t>(f_most_significant_bit(f_integer_power(3, block) - 1));
+                    std::size_t val = bitqueue.pop<std::size_t>(f_most_significant_bit(f_integer_power(3, to - from) - 1));
                     for (std::size_t i = 0; i != data_block.size(); ++i) {
                         data_block[i] = val % (3);
                         val /= 3;
@@ -1448,7 +2011,7 @@ if (bitqueue.template pop<1,uint8_t>() == 0) {          \
                 default: {
                     if (max < 7) {
                         std::span<T> data_block(begin + static_cast<std::ptrdiff_t>(from), begin + static_cast<std::ptrdiff_t>(to));
-                        std::size_t const mult = f_integer_power(static_cast<std::size_t>(max) + 1, block) - 1;
+                        std::size_t const mult = f_integer_power(static_cast<std::size_t>(max) + 1, to - from) - 1;
                         std::size_t val = bitqueue.pop<std::size_t>(f_most_significant_bit(mult));
                         for (std::size_t i = 0; i != data_block.size(); ++i) {
                             auto [quot, rem] = std::div(static_cast<std::ptrdiff_t>(val), static_cast<std::ptrdiff_t>(max + 1));
@@ -1483,7 +2046,7 @@ if (bitqueue.template pop<1,uint8_t>() == 0) {          \
             }
             else {
                 std::span<T> data_block(begin + static_cast<std::ptrdiff_t>(from), begin + static_cast<std::ptrdiff_t>(to));
-                std::size_t const mult = f_integer_power(static_cast<std::size_t>(max) + 1, block) - 1;
+                std::size_t const mult = f_integer_power(static_cast<std::size_t>(max) + 1, to - from) - 1;
                 std::size_t val = bitqueue.pop<std::size_t>(f_most_significant_bit(mult));
                 for (std::size_t i = 0; i != data_block.size(); ++i) {
                     auto [quot, rem] = std::div(static_cast<std::ptrdiff_t>(val), static_cast<std::ptrdiff_t>(max + 1));
@@ -1545,8 +2108,10 @@ if (bitqueue.template pop<1,uint8_t>() == 0) {          \
             for (auto const& val : values)
                 setbits |= val;
         else
-            for (auto const& val : values)
-                setbits |= (val == -1) ? std::size_t(1) : static_cast<std::size_t>(std::abs(val)) << 1;
+            for (auto const& val : values) {
+                std::size_t const magnitude = val < 0 ? std::size_t(0) - static_cast<std::size_t>(val) : static_cast<std::size_t>(val);
+                setbits |= (val == -1) ? std::size_t(1) : (magnitude >> (8 * sizeof(std::size_t) - 1)) ? ~std::size_t(0) : magnitude << 1;
+            }
         std::size_t r=0;
         for ( ; setbits; setbits>>=1, ++r);
         return static_cast<std::uint8_t>(std::min(r, sizeof(T0) * 8));
@@ -1563,8 +2128,8 @@ if (bitqueue.template pop<1,uint8_t>() == 0) {          \
     
     template <typename STREAM> requires std::derived_from<STREAM, std::istream>
     void f_fill_terse_frames(STREAM& istream, std::size_t const number_of_bytes) {
-        f_get_frame(0).resize(number_of_bytes);
-        istream.read(reinterpret_cast<char*>(&(f_get_frame(0)[0])), static_cast<std::ptrdiff_t>(number_of_bytes));
+        f_shared_frame(0)->resize(number_of_bytes);
+        istream.read(reinterpret_cast<char*>(f_shared_frame(0)->data()), static_cast<std::ptrdiff_t>(number_of_bytes));
         std::vector<std::size_t> terse_sizes(d_terse_frames.size());
         std::uint8_t const* terse_begin = f_get_frame(0).data();
         for (std::size_t current_frame = 0; current_frame != d_terse_frames.size(); ++current_frame) {
@@ -1587,12 +2152,246 @@ if (bitqueue.template pop<1,uint8_t>() == 0) {          \
         std::size_t data_start = terse_sizes[0];
         for (std::size_t frame_num = 1; frame_num != d_terse_frames.size(); ++frame_num) {
             terse_sizes[frame_num] = ((terse_sizes[frame_num] + sizeof(size_t) - 1) / sizeof(size_t)) * sizeof(size_t);
-            f_get_frame(frame_num).resize(terse_sizes[frame_num]);
-            std::memcpy(f_get_frame(frame_num).data(), f_get_frame(0).data() + data_start, terse_sizes[frame_num]);
+            f_shared_frame(frame_num)->resize(terse_sizes[frame_num]);
+            std::memcpy(f_shared_frame(frame_num)->data(), f_get_frame(0).data() + data_start, terse_sizes[frame_num]);
             data_start += terse_sizes[frame_num];
         }
-        f_get_frame(0).resize(terse_sizes[0]);
-        f_get_frame(0).shrink_to_fit();
+        f_shared_frame(0)->resize(terse_sizes[0]);
+        f_shared_frame(0)->shrink_to_fit();
+    }
+};
+
+/**
+ * @class Terse_view
+ * @brief A read-only view of Terse data that are held in a contiguous block of memory.
+ *
+ * A Terse_view parses the XML header of Terse data in memory (as produced by Terse::write()) and unpacks the frames
+ * directly from that memory, without copying the compressed data into a Terse object. It is meant for codecs that
+ * receive compressed data in a buffer, such as the HDF5 filter, and for memory-mapped files. The memory must remain
+ * valid for as long as the Terse_view is used.
+ *
+ * If the template parameter is Concurrent, prolix(container) unpacks the frames in parallel.
+ *
+ * Example of usage:
+ * \code{.cpp}
+ *    Terse_view<Concurrent> view(std::span<std::uint8_t const>(buffer, buffer_size));
+ *    std::vector<std::uint16_t> data(view.size() * view.number_of_frames());
+ *    view.prolix(data);
+ * \endcode
+ */
+template<typename CONCURRENT = void>
+class Terse_view {
+    template <typename T> friend class Terse;
+
+public:
+    /**
+     * @brief Parses the header of the Terse data at the start of 'memory'.
+     *
+     * Terse data without the "memory_sizes_of_frames" attribute can only be viewed if they contain a single frame.
+     *
+     * @param memory The memory that holds the Terse data. It may extend beyond the Terse data, see file_size().
+     * @throws std::invalid_argument If the memory does not start with a valid Terse header, or is too small for the
+     * frames described in the header.
+     */
+    explicit Terse_view(std::span<std::uint8_t const> const memory) {
+        std::size_t position = 0;
+        for (std::size_t const frame_size : f_parse(memory, position)) {
+            if (frame_size > memory.size() - position)
+                throw std::invalid_argument("Terse frame extends beyond the end of the memory.");
+            d_frames.push_back(memory.subspan(position, frame_size));
+            position += frame_size;
+        }
+        d_file_size = position;
+    }
+
+    /**
+     * @brief Views Terse data whose compressed frames are not stored directly after the header, e.g. after scatter-gather
+     * I/O, or when each frame was transferred as a separate buffer.
+     *
+     * @param header The memory that holds the header and the metadata, as returned by Terse::header().
+     * @param frames The memory of each compressed frame, as returned by Terse::compressed_frame().
+     * @throws std::invalid_argument If the header is not a valid Terse header, or the frames do not match the number and
+     * memory sizes of the frames in the header.
+     */
+    Terse_view(std::span<std::uint8_t const> const header, std::span<std::span<std::uint8_t const> const> const frames) {
+        std::size_t position = 0;
+        std::vector<std::size_t> const frame_sizes = f_parse(header, position);
+        if (frame_sizes.size() != frames.size())
+            throw std::invalid_argument("The number of frames differs from that in the Terse header.");
+        for (std::size_t i = 0; i != frames.size(); ++i) {
+            if (frames[i].size() != frame_sizes[i])
+                throw std::invalid_argument("The memory size of a frame differs from that in the Terse header.");
+            d_frames.push_back(frames[i]);
+            position += frames[i].size();
+        }
+        d_file_size = position;
+    }
+
+    /**
+     * @brief Unpacks a frame, storing the unpacked data from the location defined by 'begin'.
+     *
+     * @tparam Iterator The type of the iterator.
+     * @param begin The starting iterator or pointer where the data will be stored.
+     * @param frame The index of the frame to unpack (default is 0).
+     * @throws std::out_of_range If the provided frame index is greater than or equal to the number of frames.
+     * @throws std::invalid_argument If the iterator refers unsigned values, when the Terse data contain signed values.
+     */
+    template <typename Iterator> requires requires (Iterator& i) {*i;}
+    void prolix(Iterator begin, std::size_t frame = 0) {
+        if (frame >= number_of_frames()) throw std::out_of_range("Frame index is out of range.");
+        d_terse.f_prolix(begin, d_frames[frame]);
+    }
+
+    /**
+     * @brief Unpacks all frames and stores these consecutively in the provided container of numerical values. For a
+     * Terse_view<Concurrent>, the frames are unpacked in parallel.
+     *
+     * @tparam C The type of the container.
+     * @param container The container where the data will be stored.
+     * @throws std::invalid_argument If the provided container does not have exactly enough space to unpack all frames.
+     */
+    template <Container C> requires std::is_arithmetic_v<typename std::remove_cvref_t<C>::value_type>
+    C&& prolix(C&& container) {
+        if (size() * number_of_frames() != container.size())
+            throw(std::invalid_argument("The provided container not have enough space for unpacking all frames of the Terse data"));
+        auto* data_ptr = container.data();
+        if constexpr (std::is_same_v<CONCURRENT, void>)
+            for (std::size_t i = 0; i != number_of_frames(); ++i)
+                prolix(data_ptr + i * size(), i);
+        else if (number_of_frames() == 1)
+            prolix(data_ptr, 0);
+        else {
+            std::vector<std::future<void>> futures;
+            for (std::size_t i = 0; i != number_of_frames(); ++i)
+                futures.push_back(d_terse.d_concurrent->background([this, i, data_ptr] {
+                    prolix(data_ptr + i * size(), i);
+                }));
+            for (auto& future : futures) future.get();
+        }
+        return std::forward<C>(container);
+    }
+
+    /**
+     * @brief Sets the degree of parallelism used by prolix(container) of a Terse_view<Concurrent>.
+     *
+     * @param new_dop A value between 0 (sequential) and 1 (use all cores).
+     */
+    void dop(double new_dop) noexcept requires std::is_same_v<CONCURRENT, Concurrent> { d_terse.dop(new_dop); }
+
+    /**
+     * @brief Returns the number of encoded elements of a single frame.
+     */
+    std::size_t size() const noexcept { return d_terse.size(); }
+
+    /**
+     * @brief Returns the number of frames in the Terse data.
+     */
+    std::size_t number_of_frames() const noexcept { return d_frames.size(); }
+
+    /**
+     * @brief Returns the dimensions of each of the frames. Empty if the Terse data do not define dimensions.
+     */
+    std::vector<std::size_t> const& dim() const noexcept { return d_terse.dim(); }
+
+    /**
+     * @brief Returns true if the encoded data are signed, false if unsigned.
+     */
+    bool is_signed() const noexcept { return d_terse.is_signed(); }
+
+    /**
+     * @brief Returns the maximum number of bits per element that can be expected.
+     */
+    unsigned bits_per_val() const noexcept { return d_terse.bits_per_val(); }
+
+    /**
+     * @brief Returns true if any of the frames has floating point values.
+     */
+    bool is_float() const noexcept {
+        return std::any_of(d_frames.begin(), d_frames.end(), [](auto const frame) { return Terse<CONCURRENT>::f_is_float(frame); });
+    }
+
+    /**
+     * @brief Returns the number of bytes of the viewed memory that make up the Terse data, including header and metadata.
+     * Terse data that follow in the same memory block start at this offset.
+     */
+    std::size_t file_size() const noexcept { return d_file_size; }
+
+    /**
+     * @brief Returns the metadata that are associated with the specified frame, or an empty string if there are none.
+     */
+    std::string_view metadata(std::size_t frame = 0) const noexcept {
+        return frame < d_metadata.size() ? d_metadata[frame] : std::string_view();
+    }
+
+private:
+    Terse<CONCURRENT> d_terse;
+    std::vector<std::span<std::uint8_t const>> d_frames;
+    std::vector<std::string_view> d_metadata;
+    std::size_t d_file_size = 0;
+
+    // Parses the header and the metadata at the start of 'memory', and returns the memory sizes of the frames. On return,
+    // 'position' is the offset of the first frame.
+    std::vector<std::size_t> f_parse(std::span<std::uint8_t const> const memory, std::size_t& position) {
+        std::string_view const text(reinterpret_cast<char const*>(memory.data()), memory.size());
+        std::size_t const begin = text.find_first_not_of(" \t\r\n");
+        if (begin == std::string_view::npos || text.substr(begin, 7) != "<Terse ")
+            throw std::invalid_argument("Memory does not contain Terse data.");
+        std::size_t const end = text.find("/>", begin);
+        if (end == std::string_view::npos)
+            throw std::invalid_argument("Terse header is incomplete.");
+        std::string_view const header = text.substr(begin, end - begin);
+        d_terse.d_prolix_bits = static_cast<unsigned>(f_number(f_attribute(header, "prolix_bits")));
+        d_terse.d_signed = f_number(f_attribute(header, "signed")) != 0;
+        d_terse.d_block = f_number(f_attribute(header, "block"));
+        d_terse.d_size = f_number(f_attribute(header, "number_of_values"));
+        d_terse.d_dim = f_numbers(f_attribute(header, "dimensions"));
+        std::size_t const number_of_frames = f_number(f_attribute(header, "number_of_frames"));
+        std::vector<std::size_t> frame_sizes = f_numbers(f_attribute(header, "memory_sizes_of_frames"));
+        if (frame_sizes.empty() && number_of_frames == 1)
+            frame_sizes.push_back(f_number(f_attribute(header, "memory_size")));
+        if (frame_sizes.size() != number_of_frames)
+            throw std::invalid_argument("Terse header does not define the memory sizes of the frames.");
+        position = end + 2;
+        for (std::size_t const metadata_size : f_numbers(f_attribute(header, "metadata_string_sizes"))) {
+            if (metadata_size > memory.size() - position)
+                throw std::invalid_argument("Terse metadata extend beyond the end of the memory.");
+            d_metadata.push_back(text.substr(position, metadata_size));
+            position += metadata_size;
+        }
+        return frame_sizes;
+    }
+
+    static std::string_view f_attribute(std::string_view const header, std::string_view const name) noexcept {
+        for (std::size_t pos = header.find(name); pos != std::string_view::npos; pos = header.find(name, pos + 1)) {
+            std::size_t const value = pos + name.size() + 2;
+            if (header[pos - 1] == ' ' && header.substr(pos + name.size(), 2) == "=\"") {
+                std::size_t const value_end = header.find('"', value);
+                if (value_end != std::string_view::npos)
+                    return header.substr(value, value_end - value);
+            }
+        }
+        return {};
+    }
+
+    static std::vector<std::size_t> f_numbers(std::string_view values) {
+        std::vector<std::size_t> numbers;
+        for (char const* p = values.data(), *end = values.data() + values.size(); p != end; ) {
+            if (*p == ' ') { ++p; continue; }
+            std::size_t number = 0;
+            auto const [next, error] = std::from_chars(p, end, number);
+            if (error != std::errc())
+                throw std::invalid_argument("Terse header contains an invalid number.");
+            numbers.push_back(number);
+            p = next;
+        }
+        return numbers;
+    }
+
+    static std::size_t f_number(std::string_view const value) {
+        auto const numbers = f_numbers(value);
+        if (numbers.size() != 1)
+            throw std::invalid_argument("Terse header lacks a required attribute.");
+        return numbers[0];
     }
 };
 } // end namespace jpa
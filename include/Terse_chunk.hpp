@@ -0,0 +1,579 @@
+//
+//  Terse_chunk.hpp
+//  Terse
+//
+//  Encoding and decoding of the chunks of the h5terse HDF5 filter.
+//
+
+#ifndef Terse_chunk_h
+#define Terse_chunk_h
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <type_traits>
+#include <vector>
+#include "Concurrent.hpp"
+#include "Terse.hpp"
+
+// The h5terse HDF5 filter (tersecodec) stores every HDF5 chunk as Terse data. A chunk is divided into sub-chunks that
+// are compressed concurrently: either frames, defined by the two fastest-varying chunk dimensions, or flat stretches
+// of a fixed number of values. The sub-chunks of equal size form one Terse object, and any remainder forms a second
+// Terse object that directly follows the first in the chunk.
+//
+// This file implements that encoding independently of the HDF5 library, so that chunks can also be compressed and
+// decompressed outside the HDF5 filter pipeline, e.g. for H5Dwrite_chunk() / H5Dread_chunk().
+//
+// Terse_filter_parameters
+//      The parameters of the filter, as stored in the 'cd_values' of an HDF5 dataset:
+//          cd_values[0]    The type code of the data (see Terse_type_code).
+//          cd_values[1]    The number of elements per sub-chunk (0: 262144).
+//          cd_values[2]    The compression mode: 1 Signed, 2 Unsigned, 3 Small_unsigned (0: Terse_mode::Default).
+//          cd_values[3]    The Terse block size (0: 12).
+//          cd_values[4]    The maximum number of threads per chunk (0: the Terse<Concurrent> default).
+//          cd_values[5]    For floating point data, the number of significant bits of the mantissa (0: lossless).
+//          cd_values[6]    The rank of the chunks, followed by the chunk dimensions.
+//      The environment variable TERSE_FILTER_DOP, a degree of parallelism between 0 and 1, overrides cd_values[4].
+// Terse_chunk(std::span<T const> data, Terse_filter_parameters const& parameters)
+//      Compresses a chunk concurrently in the background. size() returns the number of bytes of the compressed chunk,
+//      and write() or bytes() return the bytes that the filter would produce for the same data and parameters.
+// Terse_chunk_view(std::span<std::uint8_t const> chunk)
+//      Unpacks a compressed chunk in parallel, directly from its bytes. type_code() gives the type of the values that
+//      were compressed.
+// terse_frame_chunk(Terse<C>& terse, std::size_t frame)
+//      Returns a frame of a Terse object as the bytes of a chunk of the h5terse filter, without unpacking it. The chunk
+//      holds one frame: a dataset with the parameters Terse_filter_parameters::for_frames(terse) stores each frame of
+//      'terse' as one chunk.
+// Terse_chunk_reader<T>(std::span<T> destination, std::vector<std::size_t> shape, std::vector<std::size_t> chunk_shape)
+//      Unpacks the compressed chunks of a chunked array concurrently, one chunk per task, into the C-ordered array
+//      'destination' of dimensions 'shape'. decode(chunk, offset) submits a chunk with the given element offset,
+//      copy(chunk, offset) stores a chunk that was not compressed, and wait() waits until all chunks are unpacked.
+//
+// Example:
+//
+//    std::vector<std::uint16_t> frames(10 * 512 * 512);
+//    Terse_filter_parameters parameters;
+//    parameters.type_code = terse_type_code_of<std::uint16_t>();
+//    parameters.chunk_dim = {10, 512, 512};
+//    Terse_chunk chunk(std::span<std::uint16_t const>(frames), parameters);
+//    std::vector<std::uint8_t> const bytes = chunk.bytes();   // H5Dwrite_chunk(dataset, H5P_DEFAULT, 0, offset, bytes.size(), bytes.data())
+
+namespace jpa {
+
+/**
+ * @brief The HDF5 filter ID of the h5terse filter.
+ */
+inline constexpr unsigned terse_filter_id = 32029;
+
+/**
+ * @brief The type codes of the data types that the h5terse filter supports, stored in cd_values[0].
+ */
+enum class Terse_type_code : unsigned {
+    Int16 = 0,
+    Uint16 = 1,
+    Int32 = 2,
+    Uint32 = 3,
+    Int8 = 4,
+    Uint8 = 5,
+    Int64 = 6,
+    Uint64 = 7,
+    Float32 = 8,
+    Float64 = 9
+};
+
+/**
+ * @brief Returns the type code of the h5terse filter for the arithmetic type T.
+ */
+template <typename T>
+constexpr Terse_type_code terse_type_code_of() noexcept {
+    if constexpr (std::is_floating_point_v<T>) {
+        static_assert(sizeof(T) == 4 || sizeof(T) == 8, "Unsupported floating point type");
+        return sizeof(T) == 4 ? Terse_type_code::Float32 : Terse_type_code::Float64;
+    }
+    else {
+        static_assert(std::is_integral_v<T> && (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8), "Unsupported type");
+        switch (sizeof(T)) {
+            case 1:  return std::is_signed_v<T> ? Terse_type_code::Int8  : Terse_type_code::Uint8;
+            case 2:  return std::is_signed_v<T> ? Terse_type_code::Int16 : Terse_type_code::Uint16;
+            case 4:  return std::is_signed_v<T> ? Terse_type_code::Int32 : Terse_type_code::Uint32;
+            default: return std::is_signed_v<T> ? Terse_type_code::Int64 : Terse_type_code::Uint64;
+        }
+    }
+}
+
+/**
+ * @brief Returns the type code of the h5terse filter for the values encoded in a Terse or Terse_view object.
+ */
+template <typename TERSE> requires requires (TERSE& terse) { terse.is_float(); terse.bits_per_val(); }
+Terse_type_code terse_type_code_of(TERSE& terse) {
+    unsigned const bits = terse.bits_per_val();
+    if (terse.number_of_frames() != 0 && terse.is_float())
+        return bits > 32 ? Terse_type_code::Float64 : Terse_type_code::Float32;
+    if (bits <= 8)  return terse.is_signed() ? Terse_type_code::Int8  : Terse_type_code::Uint8;
+    if (bits <= 16) return terse.is_signed() ? Terse_type_code::Int16 : Terse_type_code::Uint16;
+    if (bits <= 32) return terse.is_signed() ? Terse_type_code::Int32 : Terse_type_code::Uint32;
+    return terse.is_signed() ? Terse_type_code::Int64 : Terse_type_code::Uint64;
+}
+
+/**
+ * @brief The parameters of the h5terse filter, as stored in the cd_values of an HDF5 dataset.
+ */
+struct Terse_filter_parameters {
+    static constexpr std::size_t default_chunk_size = 1 << 18;
+    static constexpr std::size_t default_block_size = 12;
+
+    Terse_type_code type_code = Terse_type_code::Uint16;
+    std::size_t chunk_size = default_chunk_size;  // As cd_values[1], 0 selects the default
+    Terse_mode mode = Terse_mode::Default;
+    std::size_t block_size = default_block_size;
+    unsigned threads = 0;
+    unsigned precision = 0;
+    std::vector<std::size_t> chunk_dim;
+
+    /**
+     * @brief Reads the parameters from the cd_values of the filter. Absent values, or values of 0, select the default.
+     *
+     * @param cd_nelmts The number of elements in 'cd_values'.
+     * @param cd_values The filter parameters.
+     * @return The parameters, or std::nullopt if any parameter is invalid.
+     */
+    static std::optional<Terse_filter_parameters> from_cd_values(std::size_t const cd_nelmts, unsigned const cd_values[]) {
+        Terse_filter_parameters parameters;
+        auto const value = [&](std::size_t index) { return index < cd_nelmts ? cd_values[index] : 0u; };
+        if (cd_nelmts == 0 || value(0) > static_cast<unsigned>(Terse_type_code::Float64))
+            return std::nullopt;
+        parameters.type_code = static_cast<Terse_type_code>(value(0));
+        if (value(1) != 0)
+            parameters.chunk_size = value(1);
+        switch (value(2)) {
+            case 0: break;
+            case 1: parameters.mode = Terse_mode::Signed; break;
+            case 2: parameters.mode = Terse_mode::Unsigned; break;
+            case 3: parameters.mode = Terse_mode::Small_unsigned; break;
+            default: return std::nullopt;
+        }
+        if (value(3) != 0)
+            parameters.block_size = value(3);
+        parameters.threads = value(4);
+        parameters.precision = value(5);
+        if (parameters.precision == 1 || parameters.precision > 54)
+            return std::nullopt;
+        if (value(6) != 0 && cd_nelmts >= 7 + value(6))
+            parameters.chunk_dim.assign(cd_values + 7, cd_values + 7 + value(6));
+        return parameters;
+    }
+
+    /**
+     * @brief Returns the parameters of an HDF5 dataset that stores each frame of a Terse object as one chunk, with
+     * dimensions {number_of_frames, frame dimensions...}. Frames without dimensions are stored as rows.
+     */
+    template <typename C>
+    static Terse_filter_parameters for_frames(Terse<C>& terse) {
+        Terse_filter_parameters parameters;
+        parameters.type_code = terse_type_code_of(terse);
+        parameters.block_size = terse.block_size();
+        parameters.chunk_dim = terse.dim().empty() ? std::vector<std::size_t>{terse.size()} : terse.dim();
+        parameters.chunk_dim.insert(parameters.chunk_dim.begin(), 1);
+        return parameters;
+    }
+
+    /**
+     * @brief Returns the cd_values that store these parameters, e.g. for H5Pset_filter().
+     */
+    std::vector<unsigned> cd_values() const {
+        unsigned mode_code = 0;
+        switch (mode) {
+            case Terse_mode::Signed:         mode_code = 1; break;
+            case Terse_mode::Unsigned:       mode_code = 2; break;
+            case Terse_mode::Small_unsigned: mode_code = 3; break;
+            default: break;
+        }
+        std::vector<unsigned> values{static_cast<unsigned>(type_code), static_cast<unsigned>(chunk_size), mode_code,
+            static_cast<unsigned>(block_size), threads, precision};
+        if (!chunk_dim.empty()) {
+            values.push_back(static_cast<unsigned>(chunk_dim.size()));
+            for (std::size_t const d : chunk_dim)
+                values.push_back(static_cast<unsigned>(d));
+        }
+        return values;
+    }
+
+    /**
+     * @brief Returns the degree of parallelism for compression and decompression: the value of the environment variable
+     * TERSE_FILTER_DOP if it is set, otherwise the degree of parallelism that corresponds to 'threads', or std::nullopt
+     * for the Terse<Concurrent> default.
+     */
+    std::optional<double> dop() const {
+        if (char const* env = std::getenv("TERSE_FILTER_DOP")) {
+            char* end = nullptr;
+            double const dop = std::strtod(env, &end);
+            if (end != env)
+                return std::clamp(dop, 0.0, 1.0);
+        }
+        if (threads != 0)
+            return Deg_of_parallelism().cores(threads);
+        return std::nullopt;
+    }
+};
+
+/**
+ * @class Terse_chunk
+ * @brief A chunk of data compressed as by the h5terse HDF5 filter.
+ *
+ * Compression starts in the background on construction, so that multiple chunks can be compressed concurrently by
+ * constructing them one after another. The uncompressed data must remain valid until size(), write() or bytes()
+ * has been called.
+ */
+class Terse_chunk {
+public:
+    /**
+     * @brief Starts compressing a chunk.
+     *
+     * If the chunk dimensions are given in the parameters and its two fastest-varying dimensions define frames of a
+     * quarter to four times the sub-chunk size (or of at least a quarter of a smaller chunk), the chunk is divided along
+     * frame boundaries, and each frame is compressed with its 2D dimensions. Otherwise the chunk is divided in
+     * sub-chunks of 'parameters.chunk_size' values: smaller frames would not hold enough values to pay for the header
+     * of a Terse frame and a compression task each.
+     *
+     * @tparam T The type of the data.
+     * @param data The values of the chunk.
+     * @param parameters The filter parameters.
+     */
+    template <typename T> requires std::is_arithmetic_v<T>
+    Terse_chunk(std::span<T const> const data, Terse_filter_parameters const& parameters) {
+        std::size_t const chunk_size = parameters.chunk_size != 0 ? parameters.chunk_size : Terse_filter_parameters::default_chunk_size;
+        for (auto* terse : {&d_chunks, &d_rest}) {
+            terse->block_size(parameters.block_size);
+            if (auto const dop = parameters.dop()) terse->dop(*dop);
+            if (parameters.precision != 0)
+                terse->fractional_precision(std::ldexp(1.0, 1 - static_cast<int>(parameters.precision)));
+        }
+        std::vector<std::size_t> const& chunk_dim = parameters.chunk_dim;
+        std::size_t const frame_size = chunk_dim.size() < 2 ? 0 : chunk_dim.end()[-2] * chunk_dim.end()[-1];
+        if (frame_size != 0 && frame_size <= 4 * chunk_size && 4 * frame_size >= std::min(chunk_size, data.size()) &&
+            data.size() % frame_size == 0) {
+            d_chunks.dim({chunk_dim.end()[-2], chunk_dim.end()[-1]});
+            for (std::size_t pos = 0; pos != data.size(); pos += frame_size)
+                d_chunks.push_back(data.subspan(pos, frame_size), parameters.mode);
+        }
+        else {
+            std::size_t pos = 0;
+            for (; pos + chunk_size < data.size(); pos += chunk_size)
+                d_chunks.push_back(data.subspan(pos, chunk_size), parameters.mode);
+            d_rest.push_back(data.subspan(pos), parameters.mode);
+        }
+    }
+
+    /**
+     * @brief Returns the number of bytes of the compressed chunk. Waits until compression has finished.
+     */
+    std::size_t size() {
+        f_compose_headers();
+        return d_headers[0].size() + d_chunks.terse_size() + d_headers[1].size() + d_rest.terse_size();
+    }
+
+    /**
+     * @brief Writes the compressed chunk to a block of memory of at least size() bytes.
+     *
+     * @param destination Pointer to the first byte of the memory block.
+     * @return The number of bytes written.
+     */
+    std::size_t write(std::uint8_t* destination) {
+        f_compose_headers();
+        std::size_t const written = d_chunks.write(destination, d_headers[0]);
+        return written + d_rest.write(destination + written, d_headers[1]);
+    }
+
+    /**
+     * @brief Returns the bytes of the compressed chunk.
+     */
+    std::vector<std::uint8_t> bytes() {
+        std::vector<std::uint8_t> chunk(size());
+        write(chunk.data());
+        return chunk;
+    }
+
+private:
+    // Composes the headers of both Terse objects once, for size() and write(). Waits until compression has finished.
+    void f_compose_headers() {
+        if (d_composed) return;
+        if (d_chunks.number_of_frames() != 0) d_headers[0] = d_chunks.header();
+        if (d_rest.number_of_frames() != 0) d_headers[1] = d_rest.header();
+        d_composed = true;
+    }
+
+    Terse<Concurrent> d_chunks;
+    Terse<Concurrent> d_rest;
+    std::string d_headers[2];
+    bool d_composed = false;
+};
+
+/**
+ * @class Terse_chunk_view
+ * @brief A read-only view of a chunk compressed by the h5terse HDF5 filter, which unpacks the chunk in parallel
+ * directly from its bytes. The bytes must remain valid while the view is used.
+ */
+class Terse_chunk_view {
+public:
+    /**
+     * @brief Parses the Terse headers of a compressed chunk.
+     *
+     * @param chunk The bytes of the compressed chunk.
+     * @param dop The degree of parallelism for unpacking, or std::nullopt for the Terse_view<Concurrent> default.
+     * @throws std::invalid_argument If the bytes are not a valid compressed chunk.
+     */
+    explicit Terse_chunk_view(std::span<std::uint8_t const> const chunk, std::optional<double> const dop = std::nullopt) :
+    d_chunks(chunk) {
+        if (chunk.size() > d_chunks.file_size() && chunk[d_chunks.file_size()] == '<')
+            d_rest.emplace(chunk.subspan(d_chunks.file_size()));
+        if (dop) {
+            d_chunks.dop(*dop);
+            if (d_rest) d_rest->dop(*dop);
+        }
+    }
+
+    /**
+     * @brief Returns the number of values in the chunk.
+     */
+    std::size_t size() const noexcept {
+        return d_chunks.size() * d_chunks.number_of_frames() + (d_rest ? d_rest->size() * d_rest->number_of_frames() : 0);
+    }
+
+    /**
+     * @brief Returns the type code of the values in the chunk, as they were compressed.
+     */
+    Terse_type_code type_code() const {
+        return terse_type_code_of(d_chunks);
+    }
+
+    /**
+     * @brief Unpacks the chunk.
+     *
+     * @tparam T The type of the unpacked values.
+     * @param destination The memory for the unpacked values, which must hold exactly size() values.
+     * @throws std::invalid_argument If 'destination' has the wrong size, or is unsigned while the data are signed.
+     */
+    template <typename T> requires std::is_arithmetic_v<T>
+    void prolix(std::span<T> const destination) {
+        if (destination.size() != size())
+            throw std::invalid_argument("The destination does not have the size of the chunk.");
+        std::size_t const chunks_size = d_chunks.size() * d_chunks.number_of_frames();
+        d_chunks.prolix(destination.first(chunks_size));
+        if (d_rest)
+            d_rest->prolix(destination.subspan(chunks_size));
+    }
+
+private:
+    Terse_view<Concurrent> d_chunks;
+    std::optional<Terse_view<Concurrent>> d_rest;
+};
+
+/**
+ * @brief Returns a frame of a Terse object as the bytes of a chunk of the h5terse filter, without unpacking it.
+ *
+ * @param terse The Terse object.
+ * @param frame The index of the frame.
+ * @throws std::out_of_range If the frame index is out of range.
+ */
+template <typename C>
+std::vector<std::uint8_t> terse_frame_chunk(Terse<C>& terse, std::size_t const frame) {
+    Terse<C> single = terse.at(frame);
+    std::string const header = single.header();
+    std::vector<std::uint8_t> chunk(header.size() + single.terse_size());
+    single.write(chunk.data(), header);
+    return chunk;
+}
+
+/**
+ * @class Terse_chunk_reader
+ * @brief Unpacks the compressed chunks of a chunked N-dimensional array concurrently into a C-ordered array.
+ *
+ * Each chunk is unpacked by its own task on the thread pool, so that the chunks of a dataset are unpacked in parallel
+ * while the caller reads the next chunks. Chunks at the edges of the array may extend beyond it, as in HDF5; only the
+ * values inside the array are stored. The number of chunks that are submitted but not yet unpacked is bounded, so
+ * that reading cannot run arbitrarily far ahead of unpacking.
+ *
+ * @tparam T The type of the values of the array.
+ */
+template <typename T> requires std::is_arithmetic_v<T>
+class Terse_chunk_reader {
+public:
+    /**
+     * @brief Constructs a reader that stores chunks in 'destination'.
+     *
+     * @param destination The memory of the array, in C order.
+     * @param shape The dimensions of the array.
+     * @param chunk_shape The dimensions of the chunks, of the same rank as the array.
+     * @param dop The degree of parallelism for unpacking chunks.
+     * @throws std::invalid_argument If the dimensions are inconsistent with each other or with 'destination'.
+     */
+    Terse_chunk_reader(std::span<T> const destination, std::vector<std::size_t> shape, std::vector<std::size_t> chunk_shape,
+                       Deg_of_parallelism const dop = 1.0) :
+    d_destination(destination),
+    d_shape(std::move(shape)),
+    d_chunk_shape(std::move(chunk_shape)),
+    d_chunk_size(std::accumulate(d_chunk_shape.begin(), d_chunk_shape.end(), std::size_t(1), std::multiplies<>())),
+    d_concurrent(dop),
+    d_max_pending(2 * std::max(1u, Concurrent::threads())) {
+        if (d_shape.empty() || d_shape.size() != d_chunk_shape.size() || d_chunk_size == 0)
+            throw std::invalid_argument("The chunk dimensions do not match the dimensions of the array.");
+        if (std::accumulate(d_shape.begin(), d_shape.end(), std::size_t(1), std::multiplies<>()) != destination.size())
+            throw std::invalid_argument("The dimensions do not match the size of the destination.");
+        d_contiguous = std::equal(d_shape.begin() + 1, d_shape.end(), d_chunk_shape.begin() + 1);
+    }
+
+    Terse_chunk_reader(Terse_chunk_reader const&) = delete;
+    Terse_chunk_reader& operator=(Terse_chunk_reader const&) = delete;
+
+    /**
+     * @brief Waits until all submitted chunks are unpacked. Errors are discarded; call wait() to receive them.
+     */
+    ~Terse_chunk_reader() {
+        for (auto& pending : d_pending)
+            if (pending.valid()) pending.wait();
+    }
+
+    /**
+     * @brief Returns the number of chunks needed to cover the array.
+     */
+    std::size_t number_of_chunks() const noexcept {
+        std::size_t count = 1;
+        for (std::size_t i = 0; i != d_shape.size(); ++i)
+            count *= (d_shape[i] + d_chunk_shape[i] - 1) / d_chunk_shape[i];
+        return count;
+    }
+
+    /**
+     * @brief Submits a compressed chunk for unpacking. The chunk bytes are moved into the task that unpacks them.
+     *
+     * @param chunk The bytes of the compressed chunk.
+     * @param offset The index of the first element of the chunk in the array.
+     */
+    void decode(std::vector<std::uint8_t> chunk, std::span<std::size_t const> const offset) {
+        f_check_offset(offset);
+        f_submit([this, c = std::move(chunk), o = std::vector<std::size_t>(offset.begin(), offset.end())] { f_decode(c, o); });
+    }
+
+    /**
+     * @brief Submits a compressed chunk for unpacking. The chunk bytes must remain valid until wait() returns.
+     *
+     * @param chunk The bytes of the compressed chunk.
+     * @param offset The index of the first element of the chunk in the array.
+     */
+    void decode(std::span<std::uint8_t const> const chunk, std::span<std::size_t const> const offset) {
+        f_check_offset(offset);
+        f_submit([this, chunk, o = std::vector<std::size_t>(offset.begin(), offset.end())] { f_decode(chunk, o); });
+    }
+
+    /**
+     * @brief Stores a chunk that was not compressed, e.g. an HDF5 chunk for which the filter was skipped.
+     *
+     * @param chunk The values of the chunk in C order, as bytes.
+     * @param offset The index of the first element of the chunk in the array.
+     * @throws std::invalid_argument If the chunk does not have the size of a chunk, or the offset is invalid.
+     */
+    void copy(std::span<std::uint8_t const> const chunk, std::span<std::size_t const> const offset) {
+        f_check_offset(offset);
+        if (chunk.size() != d_chunk_size * sizeof(T))
+            throw std::invalid_argument("The uncompressed chunk does not have the size of a chunk.");
+        std::vector<T> values(d_chunk_size);
+        std::memcpy(values.data(), chunk.data(), chunk.size());
+        f_store(values, offset);
+    }
+
+    /**
+     * @brief Waits until all submitted chunks are unpacked.
+     *
+     * @throws The first error that occurred while unpacking a chunk.
+     */
+    void wait() {
+        while (!d_pending.empty())
+            f_retire();
+        if (d_error)
+            std::rethrow_exception(std::exchange(d_error, nullptr));
+    }
+
+private:
+    std::span<T> d_destination;
+    std::vector<std::size_t> d_shape;
+    std::vector<std::size_t> d_chunk_shape;
+    std::size_t d_chunk_size;
+    bool d_contiguous;
+    Concurrent d_concurrent;
+    std::size_t d_max_pending;
+    std::deque<std::future<void>> d_pending;
+    std::exception_ptr d_error;
+
+    template <typename F>
+    void f_submit(F&& task) {
+        while (d_pending.size() >= d_max_pending)
+            f_retire();
+        d_pending.push_back(d_concurrent.background(std::forward<F>(task)));
+    }
+
+    // Waits for the oldest submitted chunk, keeping the first error for wait().
+    void f_retire() {
+        try { d_pending.front().get(); }
+        catch (...) { if (!d_error) d_error = std::current_exception(); }
+        d_pending.pop_front();
+    }
+
+    void f_check_offset(std::span<std::size_t const> const offset) const {
+        if (offset.size() != d_shape.size())
+            throw std::invalid_argument("The chunk offset does not have the rank of the array.");
+        for (std::size_t i = 0; i != d_shape.size(); ++i)
+            if (offset[i] >= d_shape[i] || offset[i] % d_chunk_shape[i] != 0)
+                throw std::invalid_argument("The chunk offset is not the offset of a chunk of the array.");
+    }
+
+    // Unpacks a chunk, directly into the destination if the chunk is a contiguous part of it.
+    void f_decode(std::span<std::uint8_t const> const chunk, std::vector<std::size_t> const& offset) {
+        Terse_chunk_view view(chunk, 0.0);
+        if (view.size() != d_chunk_size)
+            throw std::invalid_argument("The compressed chunk does not have the size of a chunk.");
+        if (d_contiguous && offset[0] + d_chunk_shape[0] <= d_shape[0])
+            view.prolix(d_destination.subspan(offset[0] * (d_destination.size() / d_shape[0]), d_chunk_size));
+        else {
+            std::vector<T> values(d_chunk_size);
+            view.prolix(std::span(values));
+            f_store(values, offset);
+        }
+    }
+
+    // Copies the part of a chunk that lies inside the array, one row of the fastest-varying dimension at a time.
+    void f_store(std::span<T const> const values, std::span<std::size_t const> const offset) {
+        std::size_t const rank = d_shape.size();
+        std::vector<std::size_t> extent(rank);
+        for (std::size_t i = 0; i != rank; ++i)
+            extent[i] = std::min(d_chunk_shape[i], d_shape[i] - offset[i]);
+        std::vector<std::size_t> index(rank, 0);
+        while (true) {
+            std::size_t source = 0, destination = 0;
+            for (std::size_t i = 0; i != rank; ++i) {
+                source = source * d_chunk_shape[i] + index[i];
+                destination = destination * d_shape[i] + offset[i] + index[i];
+            }
+            std::copy_n(values.begin() + source, extent[rank - 1], d_destination.begin() + destination);
+            std::size_t i = rank - 1;
+            while (i-- != 0 && ++index[i] == extent[i])
+                index[i] = 0;
+            if (i == std::size_t(-1))
+                return;
+        }
+    }
+};
+
+} // end namespace jpa
+
+#endif /* Terse_chunk_h */
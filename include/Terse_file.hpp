@@ -0,0 +1,295 @@
+//
+//  Terse_file.hpp
+//  Terse
+//
+//  Loading Terse files through a memory map, and saving them with parallel positional writes.
+//
+
+#ifndef Terse_file_h
+#define Terse_file_h
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+#include "Concurrent.hpp"
+#include "Terse.hpp"
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Mapped_file(std::filesystem::path const& path)
+//      Maps a file read-only into memory. memory() returns its bytes, which remain valid until the Mapped_file is
+//      destroyed. The operating system reads the pages of the file when they are first accessed.
+// Positional_file(std::filesystem::path const& path)
+//      Creates (or truncates) a file for writing at explicit offsets. write(offset, bytes) may be called by several
+//      threads at once, each writing a different part of the file.
+// Terse<C> load_terse<C>(std::filesystem::path const& path, bool memory_map = true, bool lazy = true)
+//      Reads the first Terse object of a file. If 'memory_map' is true, the file is memory-mapped; a Terse<Concurrent>
+//      object then copies each compressed frame from the mapping when the frame is first used (lazy), so that opening
+//      even a very large file is instant, or copies all frames in parallel (not lazy). Otherwise the file is read as a
+//      stream. A memory-mapped file must not be modified while frames remain to be loaded from it.
+// void save_terse(Terse<C>& terse, std::filesystem::path const& path, bool parallel = true)
+//      Writes 'terse' to a file, as Terse::write(). For Terse<Concurrent>, with 'parallel', the compressed frames are
+//      written at their offsets in the file concurrently. As the header is composed first, all frames of 'terse' are in
+//      memory before the file is opened: a Terse object can be saved to the file from which it was lazily loaded.
+//
+// Example:
+//
+//    auto terse = load_terse<Concurrent>("run_0001.trpx");   // Instant: no frame is read yet
+//    std::vector<std::uint16_t> frame(terse.size());
+//    terse.prolix(frame.begin(), 5000);                      // Reads and unpacks frame 5000 only
+//    save_terse(terse, "copy.trpx");
+
+namespace jpa {
+
+/**
+ * @class Mapped_file
+ * @brief A file that is mapped read-only into memory.
+ */
+class Mapped_file {
+public:
+    /**
+     * @brief Maps the file at 'path' into memory.
+     *
+     * @throws std::system_error If the file cannot be opened or mapped.
+     */
+    explicit Mapped_file(std::filesystem::path const& path) {
+#if defined(_WIN32)
+        HANDLE const file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), "Failed to open " + path.string());
+        LARGE_INTEGER size;
+        bool mapped = GetFileSizeEx(file, &size) != 0;
+        if (mapped) d_size = static_cast<std::size_t>(size.QuadPart);
+        if (mapped && d_size != 0) {
+            HANDLE const mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping != nullptr) {
+                d_data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+                CloseHandle(mapping);
+            }
+            mapped = d_data != nullptr;
+        }
+        DWORD const error = GetLastError();
+        CloseHandle(file);
+        if (!mapped)
+            throw std::system_error(static_cast<int>(error), std::system_category(), "Failed to map " + path.string());
+#else
+        int const file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (file < 0)
+            throw std::system_error(errno, std::generic_category(), "Failed to open " + path.string());
+        struct stat status;
+        bool mapped = ::fstat(file, &status) == 0;
+        if (mapped) d_size = static_cast<std::size_t>(status.st_size);
+        if (mapped && d_size != 0) {
+            void* const data = ::mmap(nullptr, d_size, PROT_READ, MAP_SHARED, file, 0);
+            mapped = data != MAP_FAILED;
+            if (mapped) d_data = data;
+        }
+        int const error = errno;
+        ::close(file);
+        if (!mapped)
+            throw std::system_error(error, std::generic_category(), "Failed to map " + path.string());
+#endif
+    }
+
+    Mapped_file(Mapped_file const&) = delete;
+    Mapped_file& operator=(Mapped_file const&) = delete;
+
+    ~Mapped_file() {
+        if (d_data == nullptr) return;
+#if defined(_WIN32)
+        UnmapViewOfFile(d_data);
+#else
+        ::munmap(d_data, d_size);
+#endif
+    }
+
+    /**
+     * @brief Returns the bytes of the file.
+     */
+    std::span<std::uint8_t const> memory() const noexcept { return {static_cast<std::uint8_t const*>(d_data), d_size}; }
+
+private:
+    void* d_data = nullptr;
+    std::size_t d_size = 0;
+};
+
+/**
+ * @class Positional_file
+ * @brief A file that is written at explicit offsets, possibly by several threads at once.
+ */
+class Positional_file {
+public:
+    /**
+     * @brief Creates the file at 'path', or truncates it if it exists.
+     *
+     * @throws std::system_error If the file cannot be created.
+     */
+    explicit Positional_file(std::filesystem::path const& path) {
+#if defined(_WIN32)
+        d_file = CreateFileW(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (d_file == INVALID_HANDLE_VALUE)
+            throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), "Failed to create " + path.string());
+#else
+        d_file = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+        if (d_file < 0)
+            throw std::system_error(errno, std::generic_category(), "Failed to create " + path.string());
+#endif
+    }
+
+    Positional_file(Positional_file const&) = delete;
+    Positional_file& operator=(Positional_file const&) = delete;
+
+    ~Positional_file() {
+        try { close(); }
+        catch (...) {}
+    }
+
+    /**
+     * @brief Writes 'bytes' to the file, starting at 'offset'.
+     *
+     * @throws std::system_error If writing fails.
+     */
+    void write(std::uint64_t offset, std::span<std::uint8_t const> bytes) const {
+        while (!bytes.empty()) {
+#if defined(_WIN32)
+            OVERLAPPED position = {};
+            position.Offset = static_cast<DWORD>(offset);
+            position.OffsetHigh = static_cast<DWORD>(offset >> 32);
+            DWORD written = 0;
+            if (!WriteFile(d_file, bytes.data(), static_cast<DWORD>(std::min<std::size_t>(bytes.size(), 1 << 30)), &written, &position))
+                throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), "Failed to write file");
+#else
+            ssize_t const written = ::pwrite(d_file, bytes.data(), bytes.size(), static_cast<off_t>(offset));
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                throw std::system_error(errno, std::generic_category(), "Failed to write file");
+            }
+#endif
+            offset += static_cast<std::uint64_t>(written);
+            bytes = bytes.subspan(static_cast<std::size_t>(written));
+        }
+    }
+
+    /**
+     * @brief Closes the file. Called by the destructor, which ignores errors.
+     *
+     * @throws std::system_error If the written data cannot be committed to the file.
+     */
+    void close() {
+#if defined(_WIN32)
+        if (d_file == INVALID_HANDLE_VALUE) return;
+        bool const closed = CloseHandle(d_file) != 0;
+        d_file = INVALID_HANDLE_VALUE;
+        if (!closed)
+            throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), "Failed to close file");
+#else
+        if (d_file < 0) return;
+        bool const closed = ::close(d_file) == 0;
+        d_file = -1;
+        if (!closed)
+            throw std::system_error(errno, std::generic_category(), "Failed to close file");
+#endif
+    }
+
+private:
+#if defined(_WIN32)
+    HANDLE d_file = INVALID_HANDLE_VALUE;
+#else
+    int d_file = -1;
+#endif
+};
+
+/**
+ * @brief Reads the first Terse object of the file at 'path'.
+ *
+ * @tparam C Either void or Concurrent.
+ * @param path The path of the file.
+ * @param memory_map Whether the file is memory-mapped, rather than read as a stream.
+ * @param lazy For a memory-mapped file and Terse<Concurrent>: whether each frame is read when it is first used, rather
+ * than all frames being read in parallel.
+ * @throws std::system_error If the file cannot be opened or mapped.
+ * @throws std::invalid_argument If the file does not start with valid Terse data.
+ */
+template <typename C = void>
+Terse<C> load_terse(std::filesystem::path const& path, bool const memory_map = true, bool const lazy = true) {
+    if (!memory_map) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open())
+            throw std::system_error(std::make_error_code(std::errc::no_such_file_or_directory), "Failed to open " + path.string());
+        return Terse<C>(file);
+    }
+    auto const file = std::make_shared<Mapped_file const>(path);
+    Terse_view<C> const view(file->memory());
+    Terse<C> terse;
+    if constexpr (std::is_same_v<C, Concurrent>)
+        terse.push_back(view, file, lazy);
+    else
+        terse.push_back(view);
+    return terse;
+}
+
+/**
+ * @brief Writes a Terse object to the file at 'path', with the bytes that Terse::write() produces.
+ *
+ * @tparam C Either void or Concurrent.
+ * @param terse The Terse object. Waits until its frames have been compressed, and loads any frames that have not been
+ * loaded yet.
+ * @param path The path of the file, which is created or truncated.
+ * @param parallel For Terse<Concurrent>: whether the frames are written concurrently, each at its offset in the file.
+ * @throws std::system_error If the file cannot be written.
+ */
+template <typename C>
+void save_terse(Terse<C>& terse, std::filesystem::path const& path, bool const parallel = true) {
+    std::string const header = terse.number_of_frames() == 0 ? std::string() : terse.header();
+    std::vector<std::span<std::uint8_t const>> frames;
+    std::vector<std::uint64_t> offsets;
+    std::uint64_t offset = header.size();
+    for (std::size_t i = 0; i != terse.number_of_frames(); ++i) {
+        frames.push_back(terse.compressed_frame(i));
+        offsets.push_back(offset);
+        offset += frames.back().size();
+    }
+    Positional_file file(path);
+    file.write(0, std::span(reinterpret_cast<std::uint8_t const*>(header.data()), header.size()));
+    if constexpr (std::is_same_v<C, Concurrent>) {
+        if (parallel && frames.size() > 1) {
+            Concurrent concurrent(1.0);
+            std::vector<std::future<void>> futures;
+            for (std::size_t i = 0; i != frames.size(); ++i)
+                futures.push_back(concurrent.background([&file, &frames, &offsets, i] { file.write(offsets[i], frames[i]); }));
+            std::exception_ptr error;
+            for (auto& future : futures)
+                try { future.get(); }
+                catch (...) { if (!error) error = std::current_exception(); }
+            if (error) std::rethrow_exception(error);
+            file.close();
+            return;
+        }
+    }
+    for (std::size_t i = 0; i != frames.size(); ++i)
+        file.write(offsets[i], frames[i]);
+    file.close();
+}
+
+}  // namespace jpa
+
+#endif /* Terse_file_h */
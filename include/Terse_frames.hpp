@@ -0,0 +1,188 @@
+//
+//  Terse_frames.hpp
+//  Terse
+//
+//  Sequential iteration over the frames of a Terse object, unpacking frames ahead in the background.
+//
+
+#ifndef Terse_frames_h
+#define Terse_frames_h
+
+#include <algorithm>
+#include <cstddef>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <vector>
+#include "Concurrent.hpp"
+#include "Terse.hpp"
+
+// Terse_frames<T, TERSE>(TERSE& terse, std::size_t buffers = 4, std::size_t first = 0, std::size_t last = all)
+//      A std::ranges::input_range over the frames 'first' up to 'last' of a Terse or Terse_view object. Each element is a
+//      std::span<T const> of one unpacked frame. The next 'buffers' frames are unpacked ahead on the thread pool, into
+//      a ring of 'buffers' reusable frame buffers, so that unpacking proceeds while the caller processes the current
+//      frame. A span is valid until the iterator is incremented; memory use is bounded by 'buffers' frames. The Terse
+//      object must not be modified while it is iterated.
+// frames_of<T>(TERSE& terse, std::size_t buffers = 4, std::size_t first = 0, std::size_t last = all)
+//      Returns Terse_frames<T, TERSE>(terse, buffers, first, last).
+//
+// Example:
+//
+//    Terse<Concurrent> terse(file);
+//    for (std::span<float const> frame : frames_of<float>(terse, 8))
+//        process(frame);
+//    auto sums = frames_of<std::int32_t>(terse) | std::views::transform([](auto frame) {
+//        return std::accumulate(frame.begin(), frame.end(), 0l);
+//    });
+
+namespace jpa {
+
+/**
+ * @class Terse_frames
+ * @brief An input range over the unpacked frames of a Terse object, which unpacks the next frames in the background.
+ *
+ * Frames are unpacked into a ring of reusable buffers, one task per frame. When the range is started by begin(), the
+ * first frames are submitted to fill the ring; each increment of the iterator releases the buffer of the current frame,
+ * which is then reused for the first frame that is not yet submitted.
+ *
+ * @tparam T The type of the values of the unpacked frames.
+ * @tparam TERSE The type of the Terse object: Terse<C> or Terse_view<C>.
+ */
+template <typename T, typename TERSE>
+class Terse_frames : public std::ranges::view_interface<Terse_frames<T, TERSE>> {
+    struct State;
+
+public:
+    /**
+     * @brief The iterator of the range. Dereferencing waits until the current frame has been unpacked, and rethrows
+     * any exception of unpacking.
+     */
+    class iterator {
+    public:
+        using value_type = std::span<T const>;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+        value_type operator*() const { return d_state->f_current(); }
+        iterator& operator++() { d_state->f_advance(); return *this; }
+        void operator++(int) { ++*this; }
+        friend bool operator==(iterator const& i, std::default_sentinel_t) noexcept { return i.d_state->d_current == i.d_state->d_last; }
+
+    private:
+        friend class Terse_frames;
+        explicit iterator(State* state) noexcept : d_state(state) {}
+        State* d_state = nullptr;
+    };
+
+    /**
+     * @brief Constructs the range over the frames 'first' up to 'last' of 'terse'. Unpacking starts with begin().
+     *
+     * @param terse The Terse object, which must outlive the range and must not be modified while it is iterated.
+     * @param buffers The number of frame buffers, i.e. the maximum number of frames that are unpacked ahead.
+     * @param first The index of the first frame.
+     * @param last The index one past the last frame (by default, the number of frames).
+     * @throws std::out_of_range If the frames are not frames of the Terse object.
+     * @throws std::invalid_argument If 'buffers' is 0.
+     */
+    Terse_frames(TERSE& terse, std::size_t const buffers = 4, std::size_t const first = 0, std::size_t const last = ~std::size_t(0)) :
+    d_state(std::make_unique<State>(terse, buffers, first, std::min(last, terse.number_of_frames()))) {
+        if (first > d_state->d_last) throw std::out_of_range("Frame index is out of range.");
+        if (buffers == 0) throw std::invalid_argument("At least one frame buffer is required.");
+    }
+
+    /**
+     * @brief Starts unpacking the first frames, and returns the iterator at the first frame. The range is single-pass:
+     * begin() can be called only once.
+     */
+    iterator begin() {
+        if (d_state->d_started) throw std::logic_error("A Terse_frames range can be iterated only once.");
+        d_state->d_started = true;
+        while (d_state->d_next != d_state->d_last && d_state->d_next - d_state->d_current != d_state->d_ring.size())
+            d_state->f_submit();
+        return iterator(d_state.get());
+    }
+
+    std::default_sentinel_t end() const noexcept { return {}; }
+
+    /**
+     * @brief Returns the number of frames of the range.
+     */
+    std::size_t size() const noexcept { return d_state->d_last - d_state->d_first; }
+
+private:
+    struct State {
+        TERSE& d_terse;
+        std::vector<std::vector<T>> d_ring;
+        std::vector<std::future<void>> d_unpacked;
+        std::size_t const d_first;
+        std::size_t const d_last;
+        std::size_t d_current;  // The frame at the iterator
+        std::size_t d_next;     // The first frame that is not yet submitted
+        bool d_started = false;
+        Concurrent d_concurrent {1.0};
+
+        State(TERSE& terse, std::size_t const buffers, std::size_t const first, std::size_t const last) :
+        d_terse(terse),
+        d_ring(std::min(buffers, last - std::min(first, last))),
+        d_unpacked(d_ring.size()),
+        d_first(first),
+        d_last(last),
+        d_current(first),
+        d_next(first) {}
+
+        // The unpacking tasks write into the ring, so they must finish before it is destroyed.
+        ~State() {
+            for (auto& unpacked : d_unpacked)
+                if (unpacked.valid()) unpacked.wait();
+        }
+
+        std::size_t f_slot(std::size_t const frame) const noexcept { return (frame - d_first) % d_ring.size(); }
+
+        void f_submit() {
+            std::size_t const frame = d_next++;
+            auto& buffer = d_ring[f_slot(frame)];
+            buffer.resize(d_terse.size());
+            d_unpacked[f_slot(frame)] = d_concurrent.background([this, &buffer, frame] { d_terse.prolix(buffer.begin(), frame); });
+        }
+
+        std::span<T const> f_current() {
+            if (d_current == d_last) throw std::out_of_range("Iterator is past the last frame.");
+            auto& unpacked = d_unpacked[f_slot(d_current)];
+            if (unpacked.valid()) unpacked.get();
+            return d_ring[f_slot(d_current)];
+        }
+
+        void f_advance() {
+            if (d_current == d_last) return;
+            auto& unpacked = d_unpacked[f_slot(d_current)];
+            if (unpacked.valid()) unpacked.wait();
+            ++d_current;
+            if (d_next != d_last) f_submit();
+        }
+    };
+
+    std::unique_ptr<State> d_state;
+};
+
+/**
+ * @brief Returns an input range over the unpacked frames 'first' up to 'last' of 'terse', which unpacks up to 'buffers'
+ * frames ahead in the background.
+ *
+ * @tparam T The type of the values of the unpacked frames.
+ * @param terse The Terse object, which must outlive the range and must not be modified while it is iterated.
+ * @param buffers The number of frame buffers.
+ * @param first The index of the first frame.
+ * @param last The index one past the last frame (by default, the number of frames).
+ */
+template <typename T, typename TERSE>
+Terse_frames<T, TERSE> frames_of(TERSE& terse, std::size_t const buffers = 4, std::size_t const first = 0,
+                                 std::size_t const last = ~std::size_t(0)) {
+    return Terse_frames<T, TERSE>(terse, buffers, first, last);
+}
+
+}  // namespace jpa
+
+#endif /* Terse_frames_h */
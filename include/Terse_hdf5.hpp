@@ -0,0 +1,252 @@
+//
+//  Terse_hdf5.hpp
+//  Terse
+//
+//  Parallel reading of HDF5 datasets compressed by the h5terse filter. Requires the HDF5 library (1.10.2 or later).
+//
+
+#ifndef Terse_hdf5_h
+#define Terse_hdf5_h
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+#include "hdf5.h"
+#include "Concurrent.hpp"
+#include "Terse.hpp"
+#include "Terse_chunk.hpp"
+
+// HDF5 applies the filters of a chunked dataset one chunk at a time, inside H5Dread(). read_terse_dataset() instead
+// reads the compressed chunks with H5Dread_chunk() and unpacks them concurrently with Terse_chunk_reader, while the
+// next chunks are being read.
+//
+// read_terse_dataset(hid_t dataset, std::span<T> destination, Deg_of_parallelism dop = 1.0)
+//      Reads a whole dataset into 'destination', in C order. If the dataset is not compressed by the h5terse filter
+//      alone, or its type does not match T, it is read with H5Dread() instead.
+// terse_to_hdf5(Terse<C>& terse, hid_t location, char const* name)
+//      Creates a dataset of dimensions {number_of_frames, frame dimensions...} that stores each frame of 'terse' as one
+//      chunk of the h5terse filter. The compressed frames are written with H5Dwrite_chunk(), without unpacking and
+//      recompressing them. Returns the dataset, which must be closed with H5Dclose().
+// hdf5_to_terse<C>(hid_t dataset)
+//      The reverse: returns the frames of a dataset written by the h5terse filter, or by terse_to_hdf5(), as a Terse
+//      object, without unpacking them. The chunks of the dataset must consist of whole frames.
+//
+// Example:
+//
+//    hid_t const dataset = H5Dopen2(file, "data", H5P_DEFAULT);
+//    std::vector<std::uint16_t> frames(number_of_frames * 512 * 512);
+//    read_terse_dataset(dataset, std::span(frames));
+//    std::ofstream trpx("frames.trpx", std::ios::binary);
+//    hdf5_to_terse<Concurrent>(dataset).write(trpx);
+
+namespace jpa {
+
+/**
+ * @brief Closes an HDF5 identifier when it goes out of scope.
+ */
+struct Hdf5_handle {
+    hid_t id;
+    herr_t (*close)(hid_t);
+    ~Hdf5_handle() { if (id >= 0) close(id); }
+};
+
+/**
+ * @brief Returns the HDF5 native datatype for a type code of the h5terse filter.
+ */
+inline hid_t hdf5_native_type(Terse_type_code const type_code) {
+    switch (type_code) {
+        case Terse_type_code::Int8:    return H5T_NATIVE_INT8;
+        case Terse_type_code::Uint8:   return H5T_NATIVE_UINT8;
+        case Terse_type_code::Int16:   return H5T_NATIVE_INT16;
+        case Terse_type_code::Uint16:  return H5T_NATIVE_UINT16;
+        case Terse_type_code::Int32:   return H5T_NATIVE_INT32;
+        case Terse_type_code::Uint32:  return H5T_NATIVE_UINT32;
+        case Terse_type_code::Int64:   return H5T_NATIVE_INT64;
+        case Terse_type_code::Uint64:  return H5T_NATIVE_UINT64;
+        case Terse_type_code::Float32: return H5T_NATIVE_FLOAT;
+        default:                       return H5T_NATIVE_DOUBLE;
+    }
+}
+
+/**
+ * @brief Returns the HDF5 native datatype for the arithmetic type T.
+ */
+template <typename T>
+hid_t hdf5_native_type() { return hdf5_native_type(terse_type_code_of<T>()); }
+
+/**
+ * @brief Reads an HDF5 dataset that is compressed by the h5terse filter, unpacking its chunks in parallel.
+ *
+ * @tparam T The type of the values to read.
+ * @param dataset The HDF5 dataset.
+ * @param destination The memory for all values of the dataset, in C order.
+ * @param dop The degree of parallelism for unpacking chunks.
+ * @throws std::invalid_argument If 'destination' does not have the size of the dataset.
+ * @throws std::runtime_error If reading from the HDF5 file fails.
+ */
+template <typename T> requires std::is_arithmetic_v<T>
+void read_terse_dataset(hid_t const dataset, std::span<T> const destination, Deg_of_parallelism const dop = 1.0) {
+    Hdf5_handle const space{H5Dget_space(dataset), H5Sclose};
+    Hdf5_handle const dcpl{H5Dget_create_plist(dataset), H5Pclose};
+    if (space.id < 0 || dcpl.id < 0)
+        throw std::runtime_error("Cannot access the HDF5 dataset.");
+    int const rank = H5Sget_simple_extent_ndims(space.id);
+    std::vector<hsize_t> dims(std::max(rank, 0));
+    if (rank < 0 || H5Sget_simple_extent_dims(space.id, dims.data(), nullptr) < 0)
+        throw std::runtime_error("Cannot access the dataspace of the HDF5 dataset.");
+    std::vector<std::size_t> shape(dims.begin(), dims.end());
+    std::size_t size = 1;
+    for (std::size_t const d : shape) size *= d;
+    if (size != destination.size())
+        throw std::invalid_argument("The destination does not have the size of the HDF5 dataset.");
+    if (size == 0)
+        return;
+    bool terse_only = rank > 0 && H5Pget_layout(dcpl.id) == H5D_CHUNKED && H5Pget_nfilters(dcpl.id) == 1;
+    if (terse_only) {
+        unsigned flags = 0;
+        std::size_t cd_nelmts = 1;
+        unsigned type_code = ~0u;
+        terse_only = H5Pget_filter2(dcpl.id, 0, &flags, &cd_nelmts, &type_code, 0, nullptr, nullptr) == terse_filter_id &&
+                     cd_nelmts >= 1 && type_code == static_cast<unsigned>(terse_type_code_of<T>());
+    }
+    if (!terse_only) {
+        if (H5Dread(dataset, hdf5_native_type<T>(), H5S_ALL, H5S_ALL, H5P_DEFAULT, destination.data()) < 0)
+            throw std::runtime_error("Cannot read the HDF5 dataset.");
+        return;
+    }
+    std::vector<hsize_t> chunk_dims(rank);
+    H5Pget_chunk(dcpl.id, rank, chunk_dims.data());
+    Terse_chunk_reader<T> reader(destination, shape, std::vector<std::size_t>(chunk_dims.begin(), chunk_dims.end()), dop);
+    H5D_space_status_t status = H5D_SPACE_STATUS_ERROR;
+    bool const allocated = H5Dget_space_status(dataset, &status) >= 0 && status == H5D_SPACE_STATUS_ALLOCATED;
+    if (!allocated) {
+        T fill_value{};
+        H5Pget_fill_value(dcpl.id, hdf5_native_type<T>(), &fill_value);
+        std::fill(destination.begin(), destination.end(), fill_value);
+    }
+    std::vector<hsize_t> offset(rank, 0);
+    for (std::size_t i = 0; i != reader.number_of_chunks(); ++i) {
+        hsize_t chunk_size = 0;
+        herr_t found = 0;
+        if (allocated)
+            found = H5Dget_chunk_storage_size(dataset, offset.data(), &chunk_size);
+        else H5E_BEGIN_TRY {    // Unallocated chunks are not an error
+            found = H5Dget_chunk_storage_size(dataset, offset.data(), &chunk_size);
+        } H5E_END_TRY;
+        if (found >= 0 && chunk_size != 0) {
+            unsigned filter_mask = 0;
+            std::vector<std::uint8_t> chunk(chunk_size);
+            if (H5Dread_chunk(dataset, H5P_DEFAULT, offset.data(), &filter_mask, chunk.data()) < 0)
+                throw std::runtime_error("Cannot read a chunk of the HDF5 dataset.");
+            std::vector<std::size_t> const chunk_offset(offset.begin(), offset.end());
+            if (filter_mask & 1)
+                reader.copy(chunk, chunk_offset);
+            else
+                reader.decode(std::move(chunk), chunk_offset);
+        }
+        for (int d = rank - 1; d >= 0 && (offset[d] += chunk_dims[d]) >= dims[d]; --d)
+            offset[d] = 0;
+    }
+    reader.wait();
+}
+
+/**
+ * @brief Writes the frames of a Terse object to a new HDF5 dataset compressed by the h5terse filter, one frame per
+ * chunk, without unpacking and recompressing them.
+ *
+ * @param terse The Terse object.
+ * @param location The file or group in which to create the dataset.
+ * @param name The name of the dataset.
+ * @return The dataset, which must be closed with H5Dclose().
+ * @throws std::invalid_argument If the Terse object holds no frames.
+ * @throws std::runtime_error If writing to the HDF5 file fails.
+ */
+template <typename C>
+hid_t terse_to_hdf5(Terse<C>& terse, hid_t const location, char const* name) {
+    if (terse.number_of_frames() == 0)
+        throw std::invalid_argument("Cannot write a Terse object without frames to HDF5.");
+    auto const parameters = Terse_filter_parameters::for_frames(terse);
+    std::vector<hsize_t> dims(parameters.chunk_dim.begin(), parameters.chunk_dim.end());
+    std::vector<hsize_t> const chunk_dims = dims;
+    dims[0] = terse.number_of_frames();
+    std::vector<unsigned> const cd_values = parameters.cd_values();
+    Hdf5_handle const space{H5Screate_simple(static_cast<int>(dims.size()), dims.data(), nullptr), H5Sclose};
+    Hdf5_handle const dcpl{H5Pcreate(H5P_DATASET_CREATE), H5Pclose};
+    if (space.id < 0 || dcpl.id < 0 || H5Pset_chunk(dcpl.id, static_cast<int>(chunk_dims.size()), chunk_dims.data()) < 0 ||
+        H5Pset_filter(dcpl.id, terse_filter_id, H5Z_FLAG_OPTIONAL, cd_values.size(), cd_values.data()) < 0)
+        throw std::runtime_error("Cannot create the properties of the HDF5 dataset.");
+    hid_t const dataset = H5Dcreate2(location, name, hdf5_native_type(parameters.type_code), space.id, H5P_DEFAULT, dcpl.id, H5P_DEFAULT);
+    if (dataset < 0)
+        throw std::runtime_error("Cannot create the HDF5 dataset.");
+    std::vector<hsize_t> offset(dims.size(), 0);
+    for (std::size_t frame = 0; frame != terse.number_of_frames(); ++frame) {
+        offset[0] = frame;
+        std::vector<std::uint8_t> const chunk = terse_frame_chunk(terse, frame);
+        if (H5Dwrite_chunk(dataset, H5P_DEFAULT, 0, offset.data(), chunk.size(), chunk.data()) < 0) {
+            H5Dclose(dataset);
+            throw std::runtime_error("Cannot write a chunk of the HDF5 dataset.");
+        }
+    }
+    return dataset;
+}
+
+/**
+ * @brief Reads the frames of an HDF5 dataset compressed by the h5terse filter into a Terse object, without unpacking
+ * and recompressing them.
+ *
+ * The chunks of the dataset must span all dimensions except the first, so that each chunk holds whole frames, and
+ * they must be compressed as frames, i.e. by terse_to_hdf5(), or by the filter with frames of at most four times
+ * its sub-chunk size.
+ *
+ * @tparam C Either void or Concurrent.
+ * @param dataset The HDF5 dataset.
+ * @return The frames as a Terse object.
+ * @throws std::invalid_argument If the dataset is not compressed by the h5terse filter alone, or its chunks do not
+ * consist of whole frames.
+ * @throws std::runtime_error If reading from the HDF5 file fails.
+ */
+template <typename C = void>
+Terse<C> hdf5_to_terse(hid_t const dataset) {
+    Hdf5_handle const space{H5Dget_space(dataset), H5Sclose};
+    Hdf5_handle const dcpl{H5Dget_create_plist(dataset), H5Pclose};
+    if (space.id < 0 || dcpl.id < 0)
+        throw std::runtime_error("Cannot access the HDF5 dataset.");
+    int const rank = H5Sget_simple_extent_ndims(space.id);
+    unsigned flags = 0;
+    std::size_t cd_nelmts = 0;
+    if (rank < 2 || H5Pget_layout(dcpl.id) != H5D_CHUNKED || H5Pget_nfilters(dcpl.id) != 1 ||
+        H5Pget_filter2(dcpl.id, 0, &flags, &cd_nelmts, nullptr, 0, nullptr, nullptr) != terse_filter_id)
+        throw std::invalid_argument("The HDF5 dataset is not a stack of frames compressed by the h5terse filter alone.");
+    std::vector<hsize_t> dims(rank), chunk_dims(rank);
+    H5Sget_simple_extent_dims(space.id, dims.data(), nullptr);
+    H5Pget_chunk(dcpl.id, rank, chunk_dims.data());
+    if (!std::equal(dims.begin() + 1, dims.end(), chunk_dims.begin() + 1))
+        throw std::invalid_argument("The chunks of the HDF5 dataset do not consist of whole frames.");
+    std::size_t frame_size = 1;
+    for (int d = 1; d != rank; ++d) frame_size *= dims[d];
+    Terse<C> terse;
+    std::vector<hsize_t> offset(rank, 0);
+    for (hsize_t first = 0; first < dims[0]; first += chunk_dims[0]) {
+        offset[0] = first;
+        hsize_t chunk_size = 0;
+        unsigned filter_mask = 0;
+        if (H5Dget_chunk_storage_size(dataset, offset.data(), &chunk_size) < 0 || chunk_size == 0)
+            throw std::invalid_argument("The HDF5 dataset has unwritten chunks.");
+        std::vector<std::uint8_t> chunk(chunk_size);
+        if (H5Dread_chunk(dataset, H5P_DEFAULT, offset.data(), &filter_mask, chunk.data()) < 0)
+            throw std::runtime_error("Cannot read a chunk of the HDF5 dataset.");
+        if (filter_mask & 1)
+            throw std::invalid_argument("The HDF5 dataset has chunks that are not compressed.");
+        Terse_view<C> const view(chunk);
+        if (view.file_size() != chunk.size() || view.size() != frame_size || view.number_of_frames() != chunk_dims[0])
+            throw std::invalid_argument("The chunks of the HDF5 dataset are not compressed as frames.");
+        terse.push_back(view, 0, dims[0] - first);
+    }
+    return terse;
+}
+
+} // end namespace jpa
+
+#endif /* Terse_hdf5_h */
@@ -1,9 +1,24 @@
 import unittest
 import numpy as np
 import io
+import pickle
 import shutil
+import subprocess
 import sys
 import os
+import pathlib
+import tempfile
+import threading
+import time
+import warnings
+try:
+    import h5py
+except ImportError:
+    h5py = None
+try:
+    import numcodecs
+except ImportError:
+    numcodecs = None
 
 for root, dirs, files in os.walk('.'):
     if '__pycache__' in dirs:
@@ -11,6 +26,7 @@ for root, dirs, files in os.walk('.'):
 
 sys.path.append(os.path.join(os.getcwd(), 'build', 'pyterse/'))
 
+import pyterse
 from pyterse import Terse, TerseMode
 
 class TestTerseLibrary(unittest.TestCase):
@@ -112,6 +128,35 @@ class TestTerseLibrary(unittest.TestCase):
         terse_read = Terse(stream)
         np.testing.assert_array_equal(terse_read.prolix(), self.test_data_1d)
 
+    def test_file_operations(self):
+        """Test saving files with parallel writes, and loading them memory-mapped, lazily or as a stream"""
+        data = np.random.randint(0, 1000, size=(20, 32, 24), dtype=np.uint16)
+        terse = Terse(data)
+        terse.set_metadata(4, "frame 4")
+        with tempfile.TemporaryDirectory() as directory:
+            path = os.path.join(directory, "data.trpx")
+            terse.save(path)
+            stream = io.BytesIO()
+            terse.write(stream)
+            with open(path, "rb") as f:
+                self.assertEqual(f.read(), stream.getvalue())
+            terse.save(path + "2", parallel=False)
+            with open(path + "2", "rb") as f:
+                self.assertEqual(f.read(), stream.getvalue())
+            for mmap, lazy in ((True, True), (True, False), (False, True), (False, False)):
+                loaded = Terse.load(pathlib.Path(path), mmap=mmap, lazy=lazy)
+                self.assertEqual(loaded.number_of_frames, 20)
+                np.testing.assert_array_equal(loaded[7], data[7])
+                np.testing.assert_array_equal(loaded.prolix(), data)
+                self.assertEqual(loaded.metadata(4), "frame 4")
+            loaded = Terse.load(path)
+            loaded.erase(0)
+            loaded.save(path)
+            np.testing.assert_array_equal(Terse.load(path, mmap=False).prolix(), data[1:])
+            del loaded
+            with self.assertRaises(RuntimeError):
+                Terse.load(os.path.join(directory, "missing.trpx"))
+
     def test_compression_settings(self):
         """Test compression settings"""
         terse = Terse()
@@ -156,5 +201,462 @@ class TestTerseLibrary(unittest.TestCase):
         terse.shrink_to_fit()
         self.assertLessEqual(terse.terse_size, original_size)
 
+    def test_cancel(self):
+        """Test cancelling concurrent compression"""
+        data = np.random.randint(0, 1000, size=(4, 64, 64), dtype=np.uint16)
+        terse = Terse(data)
+        for frame in data:
+            terse.push_back(frame)
+        cancelled = pyterse.thread_pool_metrics()["cancelled_tasks"]
+        discarded = terse.cancel()
+        self.assertEqual(terse.number_of_frames + discarded, 8)
+        self.assertLessEqual(pyterse.thread_pool_metrics()["cancelled_tasks"] - cancelled, discarded)
+        for i in range(terse.number_of_frames):
+            np.testing.assert_array_equal(terse.at(i).prolix().reshape(64, 64), data[i % 4])
+        terse.push_back(data[0])
+        np.testing.assert_array_equal(terse.at(terse.number_of_frames - 1).prolix().reshape(64, 64), data[0])
+
+    def test_cancel_releases_input(self):
+        """Test that cancelling releases the arrays of frames whose compression was discarded"""
+        data = np.random.randint(0, 1000, size=(64, 64, 64), dtype=np.uint16)
+        references = sys.getrefcount(data)
+        terse = Terse()
+        for _ in range(8):
+            terse.push_back(data)
+        terse.cancel()
+        terse.wait()
+        self.assertEqual(sys.getrefcount(data), references)
+
+    def test_concurrent_python_threads(self):
+        """Test that Python threads can insert into and read from the same Terse object concurrently"""
+        data = np.random.randint(0, 1000, size=(4, 64, 64), dtype=np.uint16)
+        terse = Terse()
+        errors = []
+        def writer():
+            for frame in data:
+                terse.push_back(frame)
+        def reader():
+            for _ in range(20):
+                if len(terse) and not np.array_equal(terse.prolix(stop=1)[0], data[0]):
+                    errors.append("prolix mismatch")
+        threads = [threading.Thread(target=writer) for _ in range(4)] + [threading.Thread(target=reader) for _ in range(2)]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+        self.assertEqual(errors, [])
+        self.assertEqual(terse.number_of_frames, 16)
+        self.assertEqual(sorted(int(terse[i].sum()) for i in range(16)), sorted([int(frame.sum()) for frame in data] * 4))
+
+    def test_input_released_without_wait(self):
+        """Test that arrays are released after compression without a further call that collects them"""
+        data = np.random.randint(0, 1000, size=(16, 64, 64), dtype=np.uint16)
+        references = sys.getrefcount(data)
+        terse = Terse(data)
+        terse.shrink_to_fit()
+        deadline = time.monotonic() + 5
+        while sys.getrefcount(data) != references and time.monotonic() < deadline:
+            time.sleep(0.01)
+        self.assertEqual(sys.getrefcount(data), references)
+        np.testing.assert_array_equal(terse.prolix(), data)
+
+    def test_thread_pool_metrics(self):
+        """Test thread pool instrumentation"""
+        pyterse.reset_thread_pool_metrics()
+        data = np.random.randint(0, 100, size=(8, 64, 64), dtype=np.uint16)
+        terse = Terse(data)
+        np.testing.assert_array_equal(terse.prolix(), data)
+        metrics = pyterse.thread_pool_metrics()
+        self.assertGreaterEqual(metrics["threads"], 1)
+        self.assertEqual(len(metrics["wait_histogram"]), len(metrics["run_histogram"]))
+        # The workers may still be releasing the last tasks, so only the consistency of the snapshot is checked.
+        self.assertEqual(sum(metrics["run_histogram"]), metrics["completed_tasks"])
+        self.assertEqual(sum(metrics["wait_histogram"]), metrics["completed_tasks"])
+        self.assertLessEqual(metrics["completed_tasks"], metrics["submitted_tasks"])
+        self.assertGreaterEqual(metrics["utilization"], 0.0)
+        self.assertLessEqual(metrics["utilization"], 1.0)
+
+    def test_thread_pool_size(self):
+        """Test configuring the global thread pool"""
+        default_size = pyterse.thread_pool_size()
+        self.assertGreaterEqual(default_size, 1)
+        self.assertGreaterEqual(pyterse.available_cores(), 1)
+        pyterse.set_thread_pool_size(2)
+        self.assertEqual(pyterse.thread_pool_size(), 2)
+        data = np.random.randint(0, 100, size=(4, 32, 32), dtype=np.int32)
+        np.testing.assert_array_equal(Terse(data).prolix(), data)
+        pyterse.set_thread_pool_size(0)
+        self.assertEqual(pyterse.thread_pool_size(), default_size)
+
+    def test_compress_chunks(self):
+        """Test compressing HDF5 chunks for direct chunk writes"""
+        data = np.random.randint(-500, 500, size=(8, 64, 48), dtype=np.int16)
+        chunk = pyterse.compress_chunk(data[:4])
+        self.assertIsInstance(chunk, bytes)
+        np.testing.assert_array_equal(pyterse.decompress_chunk(chunk, np.int16, (4, 64, 48)), data[:4])
+        chunks = pyterse.compress_chunks(data, 4)
+        self.assertEqual(chunks[0], chunk)
+        np.testing.assert_array_equal(pyterse.decompress_chunk(chunks[1], np.int16, (4, 64, 48)), data[4:])
+        floats = np.random.rand(1000).astype(np.float32)
+        restored = pyterse.decompress_chunk(pyterse.compress_chunk(floats, precision=12), np.float32)
+        np.testing.assert_allclose(restored, floats, rtol=2**-10)
+        with self.assertRaises(ValueError):
+            pyterse.compress_chunks(data, 3)
+        with self.assertRaises(ValueError):
+            pyterse.decompress_chunk(chunk, np.uint16)
+
+    def test_strided_insert(self):
+        """Test compressing non-contiguous arrays, which are read through their strides"""
+        data = np.random.randint(0, 4000, size=(6, 40, 30), dtype=np.uint16)
+        data[:, ::7, ::5] = 65535
+        for view in (data[:, ::2], data[1:5, :, 3:], data[::-1, ::-3], np.asfortranarray(data), data.transpose(0, 2, 1),
+                     data[2, :, ::2], data[:, 5]):
+            self.assertFalse(view.flags.c_contiguous)
+            for mode in (pyterse.TerseMode.SIGNED, pyterse.TerseMode.UNSIGNED, pyterse.TerseMode.SMALL_UNSIGNED):
+                terse = Terse(view, mode)
+                np.testing.assert_array_equal(terse.prolix(), view)
+                self.assertEqual(terse.terse_size, Terse(np.ascontiguousarray(view), mode).terse_size)
+        floats = np.random.rand(4, 16, 16).astype(np.float32)
+        terse = Terse()
+        terse.push_back(floats[:, ::2, 1::3])
+        terse.push_back(floats[:, 1::2, ::3])
+        np.testing.assert_array_equal(terse.prolix(start=0, stop=4), Terse(floats[:, ::2, 1::3].copy()).prolix())
+        np.testing.assert_array_equal(terse.prolix(start=4, stop=8), Terse(floats[:, 1::2, ::3].copy()).prolix())
+
+    def test_decompress_chunk_out(self):
+        """Test decompressing chunks with the dtype of the chunk, into arrays, and concurrently"""
+        data = np.random.randint(-500, 500, size=(8, 64, 48), dtype=np.int16)
+        chunks = pyterse.compress_chunks(data, 2)
+        self.assertEqual(pyterse.chunk_dtype(chunks[0]), np.int16)
+        self.assertEqual(pyterse.chunk_dtype(pyterse.compress_chunk(data.astype(np.float64))), np.float64)
+        np.testing.assert_array_equal(pyterse.decompress_chunk(chunks[0]), data[:2].ravel())
+        out = np.empty((2, 64, 48), dtype=np.int16)
+        self.assertIs(pyterse.decompress_chunk(chunks[1], out=out), out)
+        np.testing.assert_array_equal(out, data[2:4])
+        restored = pyterse.decompress_chunks(chunks, dop=0.5)
+        np.testing.assert_array_equal(np.concatenate(restored), data.ravel())
+        outs = [np.empty((2, 64, 48), dtype=np.int16) for _ in chunks]
+        pyterse.decompress_chunks(chunks, out=outs)
+        np.testing.assert_array_equal(np.stack(outs).reshape(data.shape), data)
+        with self.assertRaises(ValueError):
+            pyterse.decompress_chunk(chunks[0], out=np.empty(10, dtype=np.int16))
+        with self.assertRaises(ValueError):
+            pyterse.decompress_chunk(chunks[0], out=np.empty((64, 2, 48), dtype=np.int16).transpose(1, 0, 2))
+
+    @unittest.skipIf(numcodecs is None, "requires numcodecs")
+    def test_numcodecs(self):
+        """Test the numcodecs codec"""
+        from pyterse.numcodecs import TerseCodec
+        self.assertIs(pyterse.TerseCodec, TerseCodec)
+        codec = numcodecs.get_codec({"id": "terse", "mode": "signed", "block_size": 16})
+        self.assertIsInstance(codec, TerseCodec)
+        self.assertEqual(numcodecs.get_codec(codec.get_config()), codec)
+        data = np.random.randint(-500, 500, size=(4, 64, 48), dtype=np.int32)
+        encoded = codec.encode(data)
+        np.testing.assert_array_equal(codec.decode(encoded).reshape(data.shape), data)
+        out = np.empty_like(data)
+        codec.decode(encoded, out=out)
+        np.testing.assert_array_equal(out, data)
+        np.testing.assert_array_equal(codec.decode(codec.encode(data[:, ::2, :])).reshape(4, 32, 48), data[:, ::2, :])
+        fortran = np.asfortranarray(data)
+        np.testing.assert_array_equal(codec.decode(codec.encode(fortran)).reshape(data.shape), data)
+        decoded = pyterse.decompress_chunks([encoded, codec.encode(data[::-1])])  # Outside the codec API
+        np.testing.assert_array_equal(decoded[1].reshape(data.shape), data[::-1])
+
+    def test_import_without_numcodecs(self):
+        """Test that importing pyterse does not import numcodecs"""
+        code = "import sys, pyterse; print('numcodecs' in sys.modules)"
+        result = subprocess.run([sys.executable, "-c", code], capture_output=True, text=True,
+                                env=dict(os.environ, PYTHONPATH=os.pathsep.join(sys.path)))
+        self.assertEqual(result.stdout.strip(), "False", result.stderr)
+
+    def test_small_unsigned_baseline(self):
+        """Test decoding Small_unsigned data written by the earlier encoder, one Terse object per block size"""
+        directory = pathlib.Path(__file__).parent / "data"
+        expected = np.load(directory / "small_unsigned_baseline.npy")
+        with open(directory / "small_unsigned_baseline.trpx", "rb") as f:
+            for block_size, data in zip((8, 12, 16, 22, 23, 24), expected):
+                terse = Terse(f)
+                self.assertEqual(terse.block_size(), block_size)
+                np.testing.assert_array_equal(terse.prolix(), data)
+            self.assertEqual(f.read(), b"")
+
+    def test_prolix_out(self):
+        """Test decompressing into preallocated and memory-mapped arrays, and frame ranges"""
+        data = np.random.randint(0, 1000, size=(6, 32, 16), dtype=np.uint16)
+        terse = Terse(data)
+        out = np.empty_like(data)
+        self.assertIs(terse.prolix(out), out)
+        np.testing.assert_array_equal(out, data)
+        np.testing.assert_array_equal(terse.prolix(start=2, stop=5), data[2:5])
+        wide = np.zeros((3, 32 * 16), dtype=np.int64)
+        terse.prolix(out=wide, start=3)
+        np.testing.assert_array_equal(wide.reshape(3, 32, 16), data[3:])
+        with tempfile.TemporaryDirectory() as directory:
+            mapped = np.memmap(os.path.join(directory, "frames.raw"), dtype=np.uint16, mode="w+", shape=data.shape)
+            terse.prolix(out=mapped)
+            mapped.flush()
+            np.testing.assert_array_equal(np.fromfile(os.path.join(directory, "frames.raw"), dtype=np.uint16).reshape(data.shape), data)
+            del mapped
+        with self.assertRaises(ValueError):
+            terse.prolix(out=np.empty((5, 32, 16), dtype=np.uint16))
+        with self.assertRaises(ValueError):
+            terse.prolix(out=np.empty((32, 6, 16), dtype=np.uint16).transpose(1, 0, 2))
+        with self.assertRaises(IndexError):
+            terse.prolix(start=4, stop=7)
+
+    def test_python_threads(self):
+        """Test compression, decompression and I/O from concurrent Python threads"""
+        stacks = [np.random.randint(0, 4000, size=(8, 64, 64), dtype=np.uint16) for _ in range(4)]
+        results = [None] * len(stacks)
+        def work(i):
+            stream = io.BytesIO()
+            Terse(stacks[i]).write(stream)
+            stream.seek(0)
+            results[i] = Terse(stream).prolix()
+        threads = [threading.Thread(target=work, args=(i,)) for i in range(len(stacks))]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+        for stack, result in zip(stacks, results):
+            np.testing.assert_array_equal(result, stack)
+
+    def test_indexing(self):
+        """Test NumPy-style selection of frames"""
+        data = np.random.randint(-1000, 1000, size=(12, 16, 20), dtype=np.int32)
+        terse = Terse(data)
+        self.assertEqual(len(terse), 12)
+        np.testing.assert_array_equal(terse[3], data[3])
+        np.testing.assert_array_equal(terse[-1], data[-1])
+        np.testing.assert_array_equal(terse[np.int64(5)], data[5])
+        np.testing.assert_array_equal(terse[2:9], data[2:9])
+        np.testing.assert_array_equal(terse[::-3], data[::-3])
+        np.testing.assert_array_equal(terse[[7, 1, 1, -2]], data[[7, 1, 1, -2]])
+        np.testing.assert_array_equal(terse[np.array([[0, 4], [8, 11]])], data[np.array([[0, 4], [8, 11]])])
+        mask = data[:, 0, 0] > 0
+        np.testing.assert_array_equal(terse[mask], data[mask])
+        np.testing.assert_array_equal(terse[1:10:2, 3:5, ::2], data[1:10:2, 3:5, ::2])
+        np.testing.assert_array_equal(terse[4, 2], data[4, 2])
+        self.assertEqual(terse[[]].shape, (0, 16, 20))
+        np.testing.assert_array_equal(np.asarray(terse), data)
+        np.testing.assert_array_equal(np.asarray(terse, dtype=np.float64), data.astype(np.float64))
+        with self.assertRaises(IndexError):
+            terse[12]
+        with self.assertRaises(IndexError):
+            terse[[0, -13]]
+        with self.assertRaises(TypeError):
+            terse["frame"]
+
+    def test_frame_iterator(self):
+        """Test iterating over frames that are unpacked ahead in the background"""
+        data = np.random.randint(0, 4000, size=(9, 32, 40), dtype=np.uint16)
+        terse = Terse(data)
+        for i, frame in enumerate(terse):
+            np.testing.assert_array_equal(frame, data[i])
+        self.assertEqual(i, 8)
+        kept = list(terse.frames(prefetch=2))  # Frames that are still referenced are not overwritten
+        np.testing.assert_array_equal(np.stack(kept), data)
+        sums = [int(frame.sum()) for frame in terse.frames(prefetch=1, start=3, stop=7)]
+        self.assertEqual(sums, [int(f.sum()) for f in data[3:7]])
+        self.assertEqual(list(terse.frames(start=5, stop=5)), [])
+        with self.assertRaises(IndexError):
+            terse.frames(start=2, stop=10)
+
+    def test_frame_iterator_modified(self):
+        """Test modifying a Terse object while its frames are iterated"""
+        data = np.random.randint(0, 4000, size=(8, 32, 40), dtype=np.uint16)
+        terse = Terse(data)
+        for i, frame in enumerate(terse):
+            np.testing.assert_array_equal(frame, data[i])
+            terse.push_back(frame + 1)
+        self.assertEqual(terse.number_of_frames, 16)
+        np.testing.assert_array_equal(terse.prolix()[8:], data + 1)
+        for i, frame in enumerate(terse.frames(prefetch=2, stop=4)):
+            np.testing.assert_array_equal(frame, data[i])
+            terse.erase(15 - i)
+        with self.assertRaises(RuntimeError):
+            for frame in terse:
+                terse.erase(terse.number_of_frames - 1)
+
+    def test_pickle(self):
+        """Test pickling with the compressed frames as out-of-band buffers"""
+        data = np.random.randint(-1000, 1000, size=(4, 30, 20), dtype=np.int16)
+        terse = Terse(data)
+        terse.set_metadata(1, "frame 1")
+        frame = memoryview(terse.compressed_frame(2))
+        self.assertTrue(frame.readonly)
+        stream = io.BytesIO()
+        terse.write(stream)
+        self.assertEqual(stream.getvalue(), terse.header() + b"".join(bytes(terse.compressed_frame(i)) for i in range(4)))
+        expected = bytes(frame)
+        terse.erase(2)
+        terse.shrink_to_fit()
+        self.assertEqual(bytes(frame), expected)  # The buffer shares ownership of the frame
+        terse.insert(2, data[2])
+        buffers = []
+        pickled = pickle.dumps(terse, protocol=5, buffer_callback=buffers.append)
+        self.assertEqual(len(buffers), 4)
+        self.assertLess(len(pickled), len(terse.header()) + 200)
+        restored = pickle.loads(pickled, buffers=buffers)
+        self.assertEqual(restored.metadata(1), "frame 1")
+        np.testing.assert_array_equal(restored.prolix(), data)
+        for protocol in (2, 4, 5):
+            restored = pickle.loads(pickle.dumps(terse, protocol=protocol))
+            np.testing.assert_array_equal(restored.prolix(), data)
+            self.assertEqual(restored.metadata(1), "frame 1")
+
+    def test_asynchronous_push_back(self):
+        """Test that arrays inserted without waiting are kept alive until their frames are compressed"""
+        frames = [np.random.randint(0, 4000, size=(256, 256), dtype=np.uint16) for _ in range(16)]
+        terse = Terse()
+        for frame in frames:
+            terse.push_back(frame.copy())  # The only reference to the copy is held by the Terse object
+        terse.insert(0, np.stack(frames[:2]))
+        terse.wait()
+        self.assertEqual(terse.number_of_frames, 18)
+        np.testing.assert_array_equal(terse.prolix(), np.stack(frames[:2] + frames))
+        terse.push_back(frames[0])
+        terse.flush()
+        np.testing.assert_array_equal(terse.prolix(start=18), frames[0][np.newaxis])
+
+    @unittest.skipIf(h5py is None, "requires h5py")
+    def test_read_dataset(self):
+        """Test reading an HDF5 dataset by unpacking its chunks in parallel"""
+        data = np.random.randint(0, 1000, size=(10, 40, 30), dtype=np.uint16)
+        with tempfile.TemporaryDirectory() as directory:
+            with h5py.File(os.path.join(directory, "chunks.h5"), "w") as f:
+                dcpl = h5py.h5p.create(h5py.h5p.DATASET_CREATE)
+                dcpl.set_chunk((4, 40, 16))
+                dcpl.set_filter(32029, h5py.h5z.FLAG_OPTIONAL, (1,))
+                space = h5py.h5s.create_simple(data.shape)
+                dset = h5py.Dataset(h5py.h5d.create(f.id, b"data", h5py.h5t.NATIVE_UINT16, space, dcpl=dcpl))
+                padded = np.zeros((12, 40, 32), dtype=np.uint16)
+                padded[:10, :, :30] = data
+                for i in range(0, 12, 4):
+                    for j in range(0, 32, 16):
+                        chunk = np.ascontiguousarray(padded[i:i + 4, :, j:j + 16])
+                        if (i, j) != (8, 16):
+                            dset.id.write_direct_chunk((i, 0, j), pyterse.compress_chunk(chunk))
+                expected = data.copy()
+                expected[8:, :, 16:] = 0
+                np.testing.assert_array_equal(pyterse.read_dataset(dset), expected)
+                out = np.empty_like(data)
+                self.assertIs(pyterse.read_dataset(dset, out=out), out)
+                np.testing.assert_array_equal(out, expected)
+
+    @unittest.skipIf(h5py is None, "requires h5py")
+    def test_compress_chunk_matches_filter(self):
+        """Test that compress_chunk produces the same bytes as the h5terse filter for the same parameters"""
+        plugin_dir = os.path.abspath(os.path.join("build", "tersecodec"))
+        if hasattr(h5py, "h5pl") and os.path.isdir(plugin_dir):
+            h5py.h5pl.prepend(plugin_dir.encode())
+        if not h5py.h5z.filter_avail(32029):
+            self.skipTest("requires the h5terse filter plugin")
+        integers = np.random.randint(0, 20, size=(8, 40, 32), dtype=np.uint16)
+        floats = np.random.rand(8, 40, 32).astype(np.float32)
+        cases = [(integers, (1, 0, 3, 32), dict(mode=TerseMode.SMALL_UNSIGNED, block_size=32)),
+                 (floats, (8, 0, 0, 0, 0, 12), dict(precision=12))]
+        with tempfile.TemporaryDirectory() as directory:
+            with h5py.File(os.path.join(directory, "filter.h5"), "w") as f:
+                for n, (data, cd_values, parameters) in enumerate(cases):
+                    dcpl = h5py.h5p.create(h5py.h5p.DATASET_CREATE)
+                    dcpl.set_chunk((4, 40, 16))
+                    dcpl.set_filter(32029, h5py.h5z.FLAG_MANDATORY, cd_values)
+                    space = h5py.h5s.create_simple(data.shape)
+                    dset = h5py.Dataset(h5py.h5d.create(f.id, b"data%d" % n, h5py.h5t.py_create(data.dtype), space,
+                                                        dcpl=dcpl))
+                    dset[...] = data
+                    for i in range(0, 8, 4):
+                        for j in range(0, 32, 16):
+                            filter_mask, stored = dset.id.read_direct_chunk((i, 0, j))
+                            self.assertEqual(filter_mask, 0)
+                            chunk = pyterse.compress_chunk(np.ascontiguousarray(data[i:i + 4, :, j:j + 16]), **parameters)
+                            self.assertEqual(bytes(stored), chunk)
+
+    @unittest.skipIf(h5py is None, "requires h5py")
+    def test_hdf5_transcoding(self):
+        """Test transcoding between Terse objects and HDF5 datasets without recompression"""
+        data = np.random.randint(-1000, 1000, size=(5, 32, 24), dtype=np.int32)
+        terse = Terse(data)
+        terse.set_metadata(2, "frame 2")
+        with tempfile.TemporaryDirectory() as directory:
+            with h5py.File(os.path.join(directory, "frames.h5"), "w") as f:
+                dset = pyterse.terse_to_hdf5(terse, f, "data")
+                self.assertEqual(dset.shape, data.shape)
+                self.assertEqual(dset.chunks, (1, 32, 24))
+                np.testing.assert_array_equal(pyterse.read_dataset(dset), data)
+                restored = pyterse.hdf5_to_terse(dset)
+                self.assertEqual(restored.number_of_frames, 5)
+                self.assertEqual(restored.metadata(2), "frame 2")
+                np.testing.assert_array_equal(restored.prolix(), data)
+
+    def test_stream_buffering(self):
+        """Test that buffered stream reads leave the stream directly after each Terse record"""
+        class ReadOnlyStream:
+            def __init__(self, data):
+                self.stream = io.BytesIO(data)
+            def read(self, n=-1):
+                return self.stream.read(n)
+            def seek(self, offset, whence=0):
+                return self.stream.seek(offset, whence)
+            def tell(self):
+                return self.stream.tell()
+
+        first = np.random.randint(0, 4096, size=(3, 64, 48), dtype=np.uint16)
+        second = np.random.randint(-100, 100, size=(2, 300, 300), dtype=np.int32)
+        stream = io.BytesIO()
+        stream.write(b"prefix")
+        Terse(first).write(stream)
+        end_of_first = stream.tell()
+        Terse(second).write(stream)
+        stream.write(b"suffix")
+        for reader in (io.BytesIO(stream.getvalue()), ReadOnlyStream(stream.getvalue())):
+            self.assertEqual(reader.read(6), b"prefix")
+            np.testing.assert_array_equal(Terse(reader).prolix(), first)
+            self.assertEqual(reader.tell(), end_of_first)
+            np.testing.assert_array_equal(Terse(reader).prolix(), second)
+            self.assertEqual(reader.read(), b"suffix")
+
+    @unittest.skipUnless(hasattr(os, 'fork'), "requires os.fork")
+    def test_fork_safety(self):
+        """Test that forked processes can use the thread pool"""
+        data = np.random.randint(0, 1000, size=(16, 64, 64), dtype=np.uint16)
+        terse = Terse(data)
+        pid = os.fork()
+        if pid == 0:
+            ok = np.array_equal(terse.prolix(), data) and np.array_equal(Terse(data).prolix(), data)
+            os._exit(0 if ok else 1)
+        np.testing.assert_array_equal(terse.prolix(), data)
+        _, status = os.waitpid(pid, 0)
+        self.assertEqual(os.waitstatus_to_exitcode(status), 0)
+
+    @unittest.skipUnless(hasattr(os, 'fork'), "requires os.fork")
+    def test_fork_during_nested_tasks(self):
+        """Test that fork() does not deadlock while pool tasks wait for tasks that are still queued"""
+        data = np.random.randint(0, 1000, size=(64, 64, 64), dtype=np.uint16)
+        stop = threading.Event()
+        errors = []
+        def busy():
+            # Unpacking tasks wait for the compression tasks of their frames, which may still be queued
+            while not stop.is_set():
+                if not np.array_equal(Terse(data).prolix(), data):
+                    errors.append("prolix mismatch")
+        thread = threading.Thread(target=busy)
+        thread.start()
+        try:
+            with warnings.catch_warnings():
+                warnings.simplefilter("ignore", DeprecationWarning)  # fork() with running threads
+                for _ in range(10):
+                    pid = os.fork()
+                    if pid == 0:
+                        os._exit(0 if np.array_equal(Terse(data).prolix(), data) else 1)
+                    _, status = os.waitpid(pid, 0)
+                    self.assertEqual(os.waitstatus_to_exitcode(status), 0)
+        finally:
+            stop.set()
+            thread.join()
+        self.assertEqual(errors, [])
+
 if __name__ == '__main__':
     unittest.main(verbosity=2)
\ No newline at end of file
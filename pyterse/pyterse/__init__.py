@@ -0,0 +1,13 @@
+"""Python bindings for Terse.
+
+The bindings are implemented in the extension module pyterse._pyterse. The numcodecs codec TerseCodec is defined in
+pyterse.numcodecs, which is only imported when the codec is used, so that importing pyterse does not import numcodecs.
+"""
+from ._pyterse import *
+
+
+def __getattr__(name):
+    if name == "TerseCodec":
+        from .numcodecs import TerseCodec
+        return TerseCodec
+    raise AttributeError(f"module {__name__!r} has no attribute {name!r}")
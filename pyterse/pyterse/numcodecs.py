@@ -0,0 +1,42 @@
+"""numcodecs codec that compresses chunks with Terse, e.g. as compressor of zarr arrays.
+
+The codec is registered with numcodecs under the id "terse" through the entry point in the numcodecs.codecs group,
+and when this module is imported.
+"""
+import numcodecs.abc
+import numcodecs.compat
+import numcodecs.registry
+
+from ._pyterse import TerseMode, compress_chunk, decompress_chunk, chunk_dtype
+
+
+class TerseCodec(numcodecs.abc.Codec):
+    """Codec that compresses chunks with Terse, e.g. as compressor of zarr arrays.
+
+    Chunks are stored in the format of the h5terse HDF5 filter: a chunk is split into frames (its last two
+    dimensions) or into sub-chunks of chunk_size values, which are compressed and decompressed in parallel,
+    without the GIL. The parameters are those of compress_chunk(); 0 selects the default.
+    """
+    codec_id = "terse"
+
+    def __init__(self, mode="DEFAULT", block_size=0, chunk_size=0, threads=0, precision=0):
+        self.mode = mode.name if isinstance(mode, TerseMode) else str(mode).upper()
+        self.block_size = int(block_size)
+        self.chunk_size = int(chunk_size)
+        self.threads = int(threads)
+        self.precision = int(precision)
+
+    def encode(self, buf):
+        data = numcodecs.compat.ensure_ndarray(buf)  # compress_chunk() copies non-C-contiguous arrays to C order
+        return compress_chunk(data, TerseMode.__members__[self.mode], self.chunk_size, self.block_size,
+                              self.threads, self.precision)
+
+    def decode(self, buf, out=None):
+        buf = numcodecs.compat.ensure_contiguous_ndarray(buf)
+        if out is None:
+            return decompress_chunk(buf)
+        decompress_chunk(buf, out=numcodecs.compat.ensure_contiguous_ndarray(out).view(chunk_dtype(buf)))
+        return out
+
+
+numcodecs.registry.register_codec(TerseCodec)
@@ -14,15 +14,22 @@
  #include <pybind11/stl.h>
  #include "Concurrent.hpp"
  #include "Terse.hpp"
+ #include "Terse_chunk.hpp"
+ #include "Strided_span.hpp"
+ #include "Terse_file.hpp"
  #include <pybind11/functional.h>
  #include <pybind11/numpy.h>
  #include <pybind11/complex.h>
  #include <pybind11/chrono.h>
+ #include <pybind11/stl/filesystem.h>
  #include <fstream>
  #include <future>
+ #include <mutex>
+ #include <numeric>
+ #include <unordered_map>
  
 
- PYBIND11_MODULE(pyterse, m)
+ PYBIND11_MODULE(_pyterse, m)
  {
      m.doc() = "Python bindings for Terse";
      
@@ -31,10 +38,17 @@
  
      /**
       * @class python_streambuf
-      * @brief Custom stream buffer implementation that wraps Python file-like objects
+      * @brief Buffered stream buffer that wraps Python file-like objects
       *
       * This class allows C++ streams to interact with Python file-like objects by
-      * implementing the necessary streambuf interface methods.
+      * implementing the necessary streambuf interface methods. Reads and writes go through
+      * a reusable buffer of 64 KiB, so that scanning a header character by character does not
+      * call into Python for each character, and seeks within the buffer are served without
+      * calling into Python. Large reads and writes bypass the buffer: reads are done with
+      * `readinto` directly into the destination memory when the stream supports it. The GIL is
+      * acquired for each call into Python, so that the stream can be used while the GIL is
+      * released. When the buffer is destroyed, the Python stream is positioned directly after
+      * the data that were consumed or written.
       */
      class python_streambuf : public std::streambuf {
      public:
@@ -42,50 +56,108 @@
           * @brief Construct a new python_streambuf with a Python stream
           * @param py_stream Python file-like object with read/write methods
           */
-         explicit python_streambuf(py::object py_stream) : py_stream(std::move(py_stream)), buffer(1024) {}
+         explicit python_streambuf(py::object py_stream) :
+         py_stream(std::move(py_stream)),
+         buffer(buffer_size),
+         has_readinto(py::hasattr(this->py_stream, "readinto")) {
+             setg(buffer.data(), buffer.data(), buffer.data());
+             try { buffer_position = this->py_stream.attr("tell")().cast<std::streamoff>(); }
+             catch (py::error_already_set const&) {}  // Not seekable: positions are counted from here
+         }
+
+         ~python_streambuf() override {
+             try { sync(); }
+             catch (...) {}
+         }
          
      protected:
          /**
-          * @brief Write characters to the underlying Python stream
+          * @brief Write characters to the underlying Python stream, through the buffer unless they do not fit
           * @param s Pointer to the character buffer
           * @param n Number of characters to write
           * @return Number of characters successfully written
           * @throws Various exceptions if writing fails
           */
          std::streamsize xsputn(char const* s, std::streamsize const n) override {
-             try {
-                 py_stream.attr("write")(py::bytes(s, static_cast<size_t>(n)));
-                 return n;  
+             if (n <= epptr() - pptr()) {
+                 std::memcpy(pptr(), s, static_cast<std::size_t>(n));
+                 pbump(static_cast<int>(n));
+                 return n;
              }
-             catch (const py::error_already_set& e) { throw; }
-             catch (const std::exception& e) { throw py::value_error(std::string("[xsputn] Error: ") + e.what()); }
-             catch (...) { throw std::runtime_error("[xsputn] Unknown error occurred"); }
+             f_discard_input();
+             f_flush_output();
+             if (n >= static_cast<std::streamsize>(buffer.size())) {
+                 f_write(s, n);
+                 return n;
+             }
+             setp(buffer.data(), buffer.data() + buffer.size());
+             return xsputn(s, n);
+         }
+
+         /**
+          * @brief Flush the buffer to the Python stream when it is full, and buffer one more character
+          * @param c The character to write, or EOF to only flush
+          * @return The character written, or EOF if writing fails
+          */
+         int overflow(int const c) override {
+             f_discard_input();
+             f_flush_output();
+             setp(buffer.data(), buffer.data() + buffer.size());
+             if (!traits_type::eq_int_type(c, traits_type::eof())) {
+                 *pptr() = traits_type::to_char_type(c);
+                 pbump(1);
+             }
+             return traits_type::not_eof(c);
          }
          
          /**
           * @brief Read characters from the underlying Python stream
           * @param s Pointer to the destination buffer
           * @param n Maximum number of characters to read
-          * @return Number of characters successfully read
+          * @return Number of characters successfully read, which is less than n only at the end of the stream
           * @throws Various exceptions if reading fails
           */
          std::streamsize xsgetn(char* s, std::streamsize const n) override {
-             if (n == 0) return 0;
-             try {
-                 py::bytes data = py_stream.attr("read")(n);
-                 std::string str_data = data;
-                 if (str_data.empty()) throw py::value_error("[xsgetn] No data read; stream may be at EOF.");
-                 std::streamsize size = std::min<std::streamsize>(n, str_data.size());
-                 std::copy(str_data.begin(), str_data.begin() + size, s);
-                 return size;
+             std::streamsize done = std::min<std::streamsize>(n, egptr() - gptr());
+             std::memcpy(s, gptr(), static_cast<std::size_t>(done));
+             gbump(static_cast<int>(done));
+             while (done != n) {
+                 if (n - done >= static_cast<std::streamsize>(buffer.size())) {
+                     f_flush_output();
+                     buffer_position += egptr() - eback();
+                     setg(buffer.data(), buffer.data(), buffer.data());
+                     std::streamsize const count = f_read(s + done, n - done);
+                     if (count == 0) break;
+                     buffer_position += count;
+                     done += count;
+                 }
+                 else {
+                     if (traits_type::eq_int_type(underflow(), traits_type::eof())) break;
+                     std::streamsize const count = std::min<std::streamsize>(n - done, egptr() - gptr());
+                     std::memcpy(s + done, gptr(), static_cast<std::size_t>(count));
+                     gbump(static_cast<int>(count));
+                     done += count;
+                 }
              }
-             catch (const py::error_already_set& e) { throw; }
-             catch (const std::exception& e) { throw py::value_error(std::string("[xsgetn] Error: ") + e.what()); }
-             catch (...) { throw std::runtime_error("[xsgetn] Unknown error occurred"); }
+             return done;
          }
          
          /**
-          * @brief Seek to a position within the Python stream
+          * @brief Refill the buffer from the Python stream
+          * @return The next character as an int, or EOF if no more characters
+          */
+         int underflow() override {
+             if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+             f_flush_output();
+             buffer_position += egptr() - eback();
+             std::streamsize const count = f_read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+             setg(buffer.data(), buffer.data(), buffer.data() + count);
+             if (count == 0) return traits_type::eof();
+             return traits_type::to_int_type(*gptr());
+         }
+
+         /**
+          * @brief Seek to a position within the Python stream; seeks within the buffer do not call into Python
           * @param off Offset to seek to
           * @param way Direction of seeking (beginning, current, end)
           * @param which I/O mode (not used)
@@ -93,34 +165,103 @@
           * @throws Various exceptions if seeking fails
           */
          std::streampos seekoff(std::streamoff const off, std::ios_base::seekdir const way, std::ios_base::openmode const which) override {
-             try {
-                 int whence = (way == std::ios_base::beg) ? 0 :
-                              (way == std::ios_base::cur) ? 1 :
-                              (way == std::ios_base::end) ? 2 : -1;
-                 if (whence == -1) throw py::value_error("Invalid seek direction");
-                 py_stream.attr("seek")(off, whence);
-                 auto new_pos = py_stream.attr("tell")().cast<std::streamoff>();
-                 return std::streampos(new_pos);
+             if (way == std::ios_base::cur || way == std::ios_base::beg) {
+                 std::streamoff const position = pptr() != pbase() ? buffer_position + (pptr() - pbase()) : buffer_position + (gptr() - eback());
+                 std::streamoff const target = way == std::ios_base::cur ? position + off : off;
+                 if (pptr() == pbase() && target >= buffer_position && target <= buffer_position + (egptr() - eback())) {
+                     setg(eback(), eback() + (target - buffer_position), egptr());
+                     return std::streampos(target);
+                 }
+                 return f_seek(target, 0);
              }
-             catch (const py::error_already_set& e) { throw; }
-             catch (const std::exception& e) { throw py::value_error(std::string("[seekoff] Error: ") + e.what()); }
-             catch (...) { throw std::runtime_error("[seekoff] Unknown error occurred"); }
+             if (way == std::ios_base::end)
+                 return f_seek(off, 2);
+             throw py::value_error("Invalid seek direction");
          }
-         
+
+         std::streampos seekpos(std::streampos const pos, std::ios_base::openmode const which) override {
+             return seekoff(std::streamoff(pos), std::ios_base::beg, which);
+         }
+
          /**
-          * @brief Read a character when the input buffer is empty
-          * @return The next character as an int, or EOF if no more characters
+          * @brief Write buffered output to the Python stream, and position the Python stream after the consumed input
+          * @return 0 on success
           */
-         int underflow() override {
-             char c;
-             if (xsgetn(&c, 1) == 0) return traits_type::eof();
-             setg(&c, &c, &c + 1);
-             return traits_type::to_int_type(c);
+         int sync() override {
+             f_flush_output();
+             f_discard_input();
+             return 0;
          }
          
      private:
+         static constexpr std::size_t buffer_size = 1 << 16;
          py::object py_stream;  ///< Python file-like object
-         std::vector<char> buffer;  ///< Internal buffer for streambuf operations
+         std::vector<char> buffer;  ///< Reusable buffer for reading and writing
+         bool has_readinto;  ///< Whether the Python stream can read into preallocated memory
+         std::streamoff buffer_position = 0;  ///< Position in the Python stream of the start of the buffer
+
+         std::streamsize f_read(char* s, std::streamsize const n) {
+             py::gil_scoped_acquire acquire;
+             try {
+                 if (has_readinto) {
+                     py::object const count = py_stream.attr("readinto")(py::memoryview::from_memory(s, n));
+                     return count.is_none() ? 0 : count.cast<std::streamsize>();
+                 }
+                 py::bytes const data = py_stream.attr("read")(n);
+                 char* bytes = nullptr;
+                 Py_ssize_t size = 0;
+                 if (PyBytes_AsStringAndSize(data.ptr(), &bytes, &size) != 0) throw py::error_already_set();
+                 std::memcpy(s, bytes, static_cast<std::size_t>(size));
+                 return size;
+             }
+             catch (const py::error_already_set& e) { throw; }
+             catch (const std::exception& e) { throw py::value_error(std::string("[read] Error: ") + e.what()); }
+         }
+
+         void f_write(char const* s, std::streamsize const n) {
+             py::gil_scoped_acquire acquire;
+             try {
+                 py_stream.attr("write")(py::memoryview::from_memory(s, n));
+                 buffer_position += n;
+             }
+             catch (const py::error_already_set& e) { throw; }
+             catch (const std::exception& e) { throw py::value_error(std::string("[write] Error: ") + e.what()); }
+         }
+
+         std::streampos f_seek(std::streamoff const off, int const whence) {
+             f_flush_output();
+             py::gil_scoped_acquire acquire;
+             try {
+                 py_stream.attr("seek")(off, whence);
+                 buffer_position = py_stream.attr("tell")().cast<std::streamoff>();
+                 setg(buffer.data(), buffer.data(), buffer.data());
+                 return std::streampos(buffer_position);
+             }
+             catch (const py::error_already_set& e) { throw; }
+             catch (const std::exception& e) { throw py::value_error(std::string("[seekoff] Error: ") + e.what()); }
+         }
+
+         // Writes the buffered output to the Python stream, and releases the buffer for input.
+         void f_flush_output() {
+             std::streamsize const n = pptr() - pbase();
+             setp(nullptr, nullptr);
+             if (n != 0)
+                 f_write(buffer.data(), n);
+         }
+
+         // Drops the buffered input that has not been consumed, moving the Python stream back to the consumed position.
+         void f_discard_input() {
+             if (gptr() == egptr()) {
+                 buffer_position += egptr() - eback();
+                 setg(buffer.data(), buffer.data(), buffer.data());
+                 return;
+             }
+             std::streamoff const position = buffer_position + (gptr() - eback());
+             setg(buffer.data(), buffer.data(), buffer.data());
+             py::gil_scoped_acquire acquire;
+             py_stream.attr("seek")(position, 0);
+             buffer_position = position;
+         }
      };
      
      /**
@@ -153,6 +294,236 @@
          python_streambuf buffer;  ///< Stream buffer that interfaces with Python
      };
      
+     /**
+      * @class array_reference
+      * @brief Reference to a NumPy array that is held while its frames are compressed in the background
+      *
+      * The reference can be dropped by a worker thread of the thread pool, which does not hold the GIL: the array is
+      * then queued, and its reference count is decremented by collect(), which requires the GIL. collect() is scheduled
+      * as a pending call of the interpreter when the first array is queued, and is also called by the bindings that
+      * insert, wait for or unpack frames. Worker threads thus never wait for the GIL, so Python threads can wait for
+      * compression while holding it.
+      */
+     class array_reference {
+     public:
+         /**
+          * @brief Construct a new reference to a Python object; requires the GIL
+          * @param array The Python object to keep alive
+          */
+         explicit array_reference(py::object array) : d_array(array.release().ptr()) {}
+         array_reference(array_reference const&) = delete;
+         array_reference& operator=(array_reference const&) = delete;
+
+         /**
+          * @brief Drop the reference; can be called from any thread, without the GIL
+          */
+         ~array_reference() {
+             bool first;
+             {
+                 std::lock_guard lock(mutex());
+                 first = dropped().empty();
+                 dropped().push_back(d_array);
+             }
+             if (first && Py_IsInitialized())
+                 Py_AddPendingCall([](void*) { collect(); return 0; }, nullptr);
+         }
+
+         /**
+          * @brief Decrement the reference counts of all arrays whose references were dropped; requires the GIL
+          */
+         static void collect() {
+             std::vector<PyObject*> arrays;
+             {
+                 std::lock_guard lock(mutex());
+                 arrays.swap(dropped());
+             }
+             for (auto array : arrays)
+                 Py_DECREF(array);
+         }
+
+     private:
+         PyObject* d_array;  ///< Owned reference to the Python object
+
+         // Never destroyed, as references may still be dropped while the interpreter shuts down.
+         static std::mutex& mutex() {
+             static auto* const mutex = new std::mutex;
+             return *mutex;
+         }
+
+         static std::vector<PyObject*>& dropped() {
+             static auto* const dropped = new std::vector<PyObject*>;
+             return *dropped;
+         }
+     };
+
+     /**
+      * @class terse_lock
+      * @brief Lock of a Terse object, which serializes the bindings that use it
+      *
+      * The bindings release the GIL while they compress, decompress or write, so without the lock another Python thread
+      * could modify the Terse object meanwhile. The lock is taken while holding the GIL, before it is released: if the
+      * object is locked by another thread, the GIL is released while waiting, so the other thread can still call into
+      * Python. A mutex exists for each object that is locked, and is removed when no thread holds or waits for it.
+      */
+     class terse_lock {
+     public:
+         /**
+          * @brief Lock a Terse object; requires the GIL
+          * @param terse The Terse object
+          */
+         explicit terse_lock(Terse<Concurrent> const& terse) : d_object(&terse), d_mutex(f_enter(d_object)) {
+             if (!d_mutex.try_lock()) {
+                 py::gil_scoped_release release;
+                 d_mutex.lock();
+             }
+         }
+         terse_lock(terse_lock const&) = delete;
+         terse_lock& operator=(terse_lock const&) = delete;
+
+         ~terse_lock() {
+             d_mutex.unlock();
+             std::lock_guard lock(registry_mutex());
+             auto const entry = registry().find(d_object);
+             if (--entry->second.users == 0)
+                 registry().erase(entry);
+         }
+
+     private:
+         struct object_mutex {
+             std::recursive_mutex mutex;  ///< Recursive, for Python streams that call back into the locked object
+             unsigned users = 0;  ///< Threads that hold or wait for the mutex
+         };
+
+         void const* const d_object;
+         std::recursive_mutex& d_mutex;
+
+         static std::recursive_mutex& f_enter(void const* const object) {
+             std::lock_guard lock(registry_mutex());
+             auto& entry = registry()[object];
+             ++entry.users;
+             return entry.mutex;
+         }
+
+         // Never destroyed, as objects may still be unlocked while the interpreter shuts down.
+         static std::mutex& registry_mutex() {
+             static auto* const mutex = new std::mutex;
+             return *mutex;
+         }
+
+         static std::unordered_map<void const*, object_mutex>& registry() {
+             static auto* const registry = new std::unordered_map<void const*, object_mutex>;
+             return *registry;
+         }
+     };
+
+     /**
+      * @class frame_iterator
+      * @brief Python iterator over frames of a Terse object, which unpacks the next frames in the background
+      *
+      * The next 'prefetch' frames are unpacked ahead on the thread pool, without the GIL, into a ring of prefetch + 2
+      * reusable NumPy arrays: the frames being unpacked, the frame that is returned, and the previously returned frame,
+      * which the loop variable of a for loop still references when the next frame is requested. An array is reused
+      * once it is no longer referenced elsewhere; an array that is still referenced is left to its owner and replaced.
+      * Each frame is copied from the Terse object under its lock before it is unpacked, so the object can be modified
+      * while it is iterated, also by the body of the loop.
+      */
+     class frame_iterator {
+     public:
+         /**
+          * @brief Construct an iterator over the frames 'first' up to 'last'; unpacking starts with the first next()
+          * @param terse The Terse object
+          * @param prefetch Number of frames that are unpacked ahead
+          * @param first Index of the first frame
+          * @param last Index one past the last frame
+          * @param dtype Data type of the frame arrays
+          * @param shape Shape of the frame arrays
+          * @param unpack Function that unpacks a single-frame Terse object into the memory of a frame array; called
+          * without the GIL
+          */
+         frame_iterator(std::shared_ptr<Terse<Concurrent>> terse, std::size_t const prefetch, std::size_t const first,
+                        std::size_t const last, py::dtype dtype, std::vector<std::size_t> shape,
+                        std::function<void(Terse<Concurrent>&, void*)> unpack) :
+         d_terse(std::move(terse)),
+         d_prefetch(std::max<std::size_t>(prefetch, 1)),
+         d_ring(d_prefetch + 2),
+         d_unpacked(d_ring.size()),
+         d_current(first),
+         d_next(first),
+         d_last(last),
+         d_first(first),
+         d_dtype(std::move(dtype)),
+         d_shape(std::move(shape)),
+         d_unpack(std::move(unpack)) {}
+
+         frame_iterator(frame_iterator const&) = delete;
+         frame_iterator& operator=(frame_iterator const&) = delete;
+
+         // The unpacking tasks write into the arrays of the ring, so they must finish first.
+         ~frame_iterator() {
+             for (auto& unpacked : d_unpacked)
+                 if (unpacked.valid()) unpacked.wait();
+         }
+
+         /**
+          * @brief Return the next frame, after submitting the frames that follow it for unpacking
+          * @return The frame as a NumPy array
+          * @throws py::stop_iteration after the last frame
+          * @throws std::runtime_error if a frame to be unpacked was removed from the Terse object, or the frame size changed
+          */
+         py::object next() {
+             if (d_current == d_last) throw py::stop_iteration();
+             while (d_next != d_last && d_next - d_current <= d_prefetch)
+                 f_submit();
+             std::size_t const slot = f_slot(d_current++);
+             auto unpacked = std::move(d_unpacked[slot]);
+             {
+                 py::gil_scoped_release release;
+                 unpacked.wait();
+             }
+             unpacked.get();
+             return d_ring[slot];
+         }
+
+     private:
+         std::shared_ptr<Terse<Concurrent>> d_terse;  ///< Keeps the Terse object alive while it is iterated
+         std::size_t const d_prefetch;  ///< Number of frames that are unpacked ahead
+         std::vector<py::object> d_ring;  ///< Frame arrays, indexed by slot
+         std::vector<std::future<void>> d_unpacked;  ///< Unpacking tasks, indexed by slot
+         std::size_t d_current;  ///< The next frame to return
+         std::size_t d_next;  ///< The first frame that is not submitted
+         std::size_t const d_last;
+         std::size_t const d_first;
+         py::dtype const d_dtype;
+         std::vector<std::size_t> const d_shape;
+         std::function<void(Terse<Concurrent>&, void*)> const d_unpack;
+         Concurrent d_concurrent {1.0};
+
+         std::size_t f_slot(std::size_t const frame) const noexcept { return (frame - d_first) % d_ring.size(); }
+
+         // The frame is copied under the lock, so that the unpacking task does not refer to the Terse object, which may be
+         // modified meanwhile. Copying waits for compression of the frame, so an unpacking task never blocks a worker
+         // thread on a compression task that is still queued in the same pool.
+         void f_submit() {
+             std::size_t const frame = d_next;
+             std::shared_ptr<Terse<Concurrent>> copy;
+             {
+                 terse_lock lock(*d_terse);
+                 std::size_t const size = std::accumulate(d_shape.begin(), d_shape.end(), std::size_t(1), std::multiplies<>());
+                 if (frame >= d_terse->number_of_frames() || d_terse->size() != size)
+                     throw std::runtime_error("The Terse object was changed during iteration: frame " + std::to_string(frame) +
+                                              " was removed or has a different size.");
+                 py::gil_scoped_release release;
+                 copy = std::make_shared<Terse<Concurrent>>(d_terse->at(frame));
+             }
+             auto& array = d_ring[f_slot(frame)];
+             if (!array || array.ref_count() > 1)
+                 array = py::array(d_dtype, d_shape);
+             void* const data = py::reinterpret_borrow<py::array>(array).mutable_data();
+             d_unpacked[f_slot(frame)] = d_concurrent.background([this, data, copy = std::move(copy)] { d_unpack(*copy, data); });
+             ++d_next;
+         }
+     };
+
      /**
       * @brief Select appropriate Terse function based on NumPy array dtype
       * @param data NumPy array to analyze
@@ -218,7 +589,11 @@
      };
      
      /**
-      * @brief Insert data from a NumPy array into a Terse object
+      * @brief Insert data from a NumPy array into a Terse object, without waiting for compression
+      *
+      * The frames are compressed in the background, and the array is referenced until its last frame has been
+      * compressed, so it must not be modified before wait() returns. Frames of non-contiguous arrays (slices, transposed
+      * or Fortran-ordered arrays) are read through their strides, block by block, without copying the array.
       * @tparam T C++ data type of the array elements
       * @param terse Target Terse object
       * @param pos Position to insert at
@@ -238,37 +613,189 @@
              static_cast<std::size_t>(std::accumulate(dim.begin(), dim.end(), 1ul, std::multiplies<>())));
          size_t const num_frames = shape.size() <= 2 ? 1 : shape[0];
          T* base_ptr = static_cast<T*>(buf.ptr);
-         for (std::size_t i = 0; i < num_frames; ++i)
-             terse.insert(pos + i, std::span(base_ptr + i * frame_size, frame_size), mode);
-         terse.shrink_to_fit();
+         std::ptrdiff_t const frame_stride = shape.size() <= 2 ? 0 : buf.strides[0];
+         auto const strides = std::vector<std::ptrdiff_t>(buf.strides.end() - static_cast<std::ptrdiff_t>(dim.size()), buf.strides.end());
+         bool const contiguous = Strided_span<T const>(base_ptr, dim, strides).contiguous();
+         array_reference::collect();
+         auto reference = std::make_shared<array_reference>(data);
+         py::gil_scoped_release release;
+         for (std::size_t i = 0; i < num_frames; ++i) {
+             auto const frame = reinterpret_cast<T*>(reinterpret_cast<std::byte*>(base_ptr) + static_cast<std::ptrdiff_t>(i) * frame_stride);
+             if (contiguous)
+                 terse.insert(pos + i, std::span(frame, frame_size), mode, [reference]() mutable { reference.reset(); });
+             else
+                 terse.insert(pos + i, Strided_span<T const>(frame, dim, strides), mode, [reference]() mutable { reference.reset(); });
+         }
      };
      
      /**
-      * @brief Decompress Terse data into a NumPy array
+      * @brief Decompress frames of Terse data directly into a NumPy array, without intermediate buffers
       * @tparam T C++ data type of the array elements
       * @param terse Source Terse object
-      * @param data Target NumPy array
+      * @param data Target array: any writable C-contiguous array (including np.memmap and shared memory) that holds
+      *             exactly the values of the frames
+      * @param first Index of the first frame to decompress
+      * @param last Index one past the last frame to decompress
       * @param type Type tag used for template deduction
-      * @throws py::value_error if dimensions do not match
+      * @throws py::value_error if the array is not writable and C-contiguous, or its size does not match
       */
-     auto prolix = [&] <typename T> (Terse<Concurrent>& terse, py::array& data, T type) {
-         auto const buf = data.request();
-         auto const shape = std::vector<size_t>(buf.shape.begin(), buf.shape.end());
-         if (terse.dim().empty()) {
-             if (shape.size() != 1 || shape[0] != terse.size())
-                 throw py::value_error("Dimension mismatch: Terse cannot expand data into array because of shape mismatch.");
+     auto prolix = [&] <typename T> (Terse<Concurrent>& terse, py::array& data, std::size_t first, std::size_t last, T type) {
+         if (!data.writeable() || !(data.flags() & py::array::c_style))
+             throw py::value_error("Terse can only expand data into a writable C-contiguous array.");
+         if (static_cast<std::size_t>(data.size()) != (last - first) * terse.size())
+             throw py::value_error("Dimension mismatch: Terse cannot expand data into array because of shape mismatch.");
+         T* const base_ptr = static_cast<T*>(data.mutable_data());
+         {
+             py::gil_scoped_release release;
+             terse.prolix(base_ptr, first, last);
+         }
+         array_reference::collect();
+     };
+
+     /**
+      * @brief Decompress selected frames of a Terse object in parallel into a new array
+      * @param terse Source Terse object
+      * @param frames Indices of the frames, in the order in which they are stored in the array
+      * @param shape Shape of the selection of frames, to which the dimensions of the frames are appended
+      * @return Array of the decompressed frames
+      */
+     auto prolix_frames = [select_terse_func, pydtype_of_terse] (Terse<Concurrent>& terse, std::vector<std::size_t> const& frames, std::vector<std::size_t> shape) {
+         std::vector<size_t> const dim = terse.dim().empty() ? std::vector<size_t>{terse.size()} : terse.dim();
+         shape.insert(shape.end(), dim.begin(), dim.end());
+         py::array data(pydtype_of_terse(terse), shape);
+         select_terse_func(data, [&](auto Type) {
+             auto* const base_ptr = static_cast<decltype(Type)*>(data.mutable_data());
+             py::gil_scoped_release release;
+             terse.prolix(base_ptr, std::span<std::size_t const>(frames));
+         });
+         array_reference::collect();
+         return data;
+     };
+
+     /**
+      * @brief Select and decompress frames with NumPy indexing: the first index selects frames, with an integer, a
+      * slice, an array of integers or a boolean mask; further indices are applied to the decompressed frames
+      * @param terse Source Terse object
+      * @param key Index, or tuple of indices
+      * @return Array of the selected data
+      * @throws py::index_error if a frame index is out of range
+      * @throws py::type_error if the frames cannot be selected with the index
+      */
+     auto getitem = [prolix_frames] (Terse<Concurrent>& terse, py::object key) -> py::object {
+         py::tuple rest;
+         if (py::isinstance<py::tuple>(key)) {
+             auto const keys = py::reinterpret_borrow<py::tuple>(key);
+             rest = py::tuple(keys.empty() ? 0 : keys.size() - 1);
+             for (std::size_t i = 1; i < keys.size(); ++i)
+                 rest[i - 1] = keys[i];
+             if (keys.empty())
+                 key = py::slice(0, static_cast<py::ssize_t>(terse.number_of_frames()), 1);
+             else
+                 key = keys[0];
          }
-         else if (terse.number_of_frames() == 1) {
-             if (terse.dim() != shape)
-                 throw py::value_error("Dimension mismatch: Terse cannot expand data into array because of shape mismatch.");
+         auto const n = static_cast<py::ssize_t>(terse.number_of_frames());
+         auto frame_index = [n](py::ssize_t const index) {
+             if (index < -n || index >= n)
+                 throw py::index_error("Requested frame not present: index out of range.");
+             return static_cast<std::size_t>(index < 0 ? index + n : index);
+         };
+         std::vector<std::size_t> frames;
+         std::vector<std::size_t> shape;
+         if (py::isinstance<py::slice>(key)) {
+             py::ssize_t start = 0, stop = 0, step = 0, length = 0;
+             if (!py::reinterpret_borrow<py::slice>(key).compute(n, &start, &stop, &step, &length))
+                 throw py::error_already_set();
+             for (py::ssize_t i = 0; i != length; ++i)
+                 frames.push_back(static_cast<std::size_t>(start + i * step));
+             shape.push_back(static_cast<std::size_t>(length));
          }
-         else if (terse.dim() != std::vector<size_t>(shape.begin() + 1, shape.end()) && shape[0] != terse.number_of_frames())
-             throw py::value_error("Dimension mismatch: Terse cannot expand data into array because of shape mismatch.");
-         T* base_ptr = static_cast<T*>(buf.ptr);
-         std::vector<std::span<T>> frames;
-         for (std::size_t i = 0; i != terse.number_of_frames(); ++i)
-             frames.push_back(std::span<T>(base_ptr + i * terse.size(), terse.size()));
-         terse.prolix(frames);
+         else if (PyIndex_Check(key.ptr()) && !py::isinstance<py::array>(key)) {
+             py::ssize_t const index = PyNumber_AsSsize_t(key.ptr(), PyExc_IndexError);
+             if (index == -1 && PyErr_Occurred()) throw py::error_already_set();
+             frames.push_back(frame_index(index));
+         }
+         else {
+             py::array indices = py::array::ensure(key);
+             if (indices && indices.dtype().kind() == 'b') {
+                 if (indices.ndim() != 1 || indices.shape(0) != n)
+                     throw py::index_error("A boolean mask must have one element per frame.");
+                 indices = py::module_::import("numpy").attr("flatnonzero")(indices);
+             }
+             if (!indices || (indices.size() != 0 && indices.dtype().kind() != 'i' && indices.dtype().kind() != 'u'))
+                 throw py::type_error("Frames can only be selected with an integer, a slice, an array of integers or a boolean mask.");
+             auto const values = py::array_t<py::ssize_t, py::array::c_style | py::array::forcecast>::ensure(indices);
+             if (!values) throw py::error_already_set();
+             for (py::ssize_t i = 0; i != values.size(); ++i)
+                 frames.push_back(frame_index(values.data()[i]));
+             shape.assign(indices.shape(), indices.shape() + indices.ndim());
+         }
+         py::array data = prolix_frames(terse, frames, shape);
+         if (rest.empty())
+             return data;
+         py::tuple index(shape.size() + rest.size());
+         for (std::size_t i = 0; i != shape.size(); ++i)
+             index[i] = py::slice(0, static_cast<py::ssize_t>(shape[i]), 1);
+         for (std::size_t i = 0; i != rest.size(); ++i)
+             index[shape.size() + i] = rest[i];
+         return data.attr("__getitem__")(index);
+     };
+
+     /**
+      * @brief Create an iterator over frames of a Terse object that unpacks the next frames in the background
+      * @param terse Source Terse object
+      * @param prefetch Number of frames that are unpacked ahead
+      * @param start Index of the first frame
+      * @param stop Index one past the last frame (by default, the number of frames)
+      * @return The iterator
+      * @throws py::index_error if the frame range is out of bounds
+      */
+     auto frames = [select_terse_func, pydtype_of_terse] (std::shared_ptr<Terse<Concurrent>> terse, std::size_t prefetch, std::size_t start, std::optional<std::size_t> stop) {
+         terse_lock lock(*terse);
+         std::size_t const last = stop.value_or(terse->number_of_frames());
+         if (start > last || last > terse->number_of_frames())
+             throw py::index_error("Requested frames not present: the frame range is out of bounds.");
+         std::vector<size_t> shape = terse->dim().empty() ? std::vector<size_t>{terse->size()} : terse->dim();
+         py::array frame(pydtype_of_terse(*terse), std::vector<size_t>{0});
+         auto unpack = select_terse_func(frame, [&](auto Type) -> std::function<void(Terse<Concurrent>&, void*)> {
+             using T = decltype(Type);
+             return [](Terse<Concurrent>& copy, void* const data) { copy.prolix(static_cast<T*>(data)); };
+         });
+         return std::make_shared<frame_iterator>(terse, prefetch, start, last, frame.dtype(), std::move(shape), std::move(unpack));
+     };
+
+     /**
+      * @brief Wait until all frames have been compressed, and release the arrays they were compressed from
+      * @param terse The Terse object
+      */
+     auto wait = [] (Terse<Concurrent>& terse) {
+         {
+             terse_lock lock(terse);
+             py::gil_scoped_release release;
+             terse.shrink_to_fit();
+         }
+         array_reference::collect();
+     };
+
+     /**
+      * @brief Bind a member function of Terse, which is called while the Terse object is locked
+      * @param method The member function
+      * @return Function that takes the Terse object and the arguments of the member function
+      */
+     auto locked = [] <typename R, typename... Args, bool NE> (R (Terse<Concurrent>::*method)(Args...) noexcept(NE)) {
+         return [method](Terse<Concurrent>& terse, Args... args) -> std::remove_cvref_t<R> {
+             terse_lock lock(terse);
+             return (terse.*method)(std::forward<Args>(args)...);
+         };
+     };
+
+     /**
+      * @brief Bind a const member function of Terse, which is called while the Terse object is locked; see locked
+      */
+     auto locked_const = [] <typename R, typename... Args, bool NE> (R (Terse<Concurrent>::*method)(Args...) const noexcept(NE)) {
+         return [method](Terse<Concurrent> const& terse, Args... args) -> std::remove_cvref_t<R> {
+             terse_lock lock(terse);
+             return (terse.*method)(std::forward<Args>(args)...);
+         };
      };
      
  
@@ -282,9 +809,414 @@
          .value("DEFAULT", Terse_mode::Default, "Default mode based on data type")
          .export_values();
      
+     /**
+      * @brief Snapshot of the global thread pool used for concurrent compression and decompression
+      */
+     m.def("thread_pool_metrics", []() -> py::dict {
+         auto const metrics = Concurrent::metrics();
+         auto const seconds = [](std::chrono::nanoseconds ns) { return std::chrono::duration<double>(ns).count(); };
+         py::dict running_per_instance;
+         for (auto const& [id, count] : metrics.running_per_instance)
+             running_per_instance[py::int_(id)] = count;
+         py::dict result;
+         result["threads"] = metrics.threads;
+         result["idle_threads"] = metrics.idle_threads;
+         result["queued_tasks"] = metrics.queued_tasks;
+         result["running_tasks"] = metrics.running_tasks;
+         result["running_per_instance"] = running_per_instance;
+         result["submitted_tasks"] = metrics.submitted_tasks;
+         result["completed_tasks"] = metrics.completed_tasks;
+         result["inline_tasks"] = metrics.inline_tasks;
+         result["cancelled_tasks"] = metrics.cancelled_tasks;
+         result["max_queued_tasks"] = metrics.max_queued_tasks;
+         result["total_wait_time"] = seconds(metrics.total_wait_time);
+         result["total_run_time"] = seconds(metrics.total_run_time);
+         result["mean_wait_time"] = seconds(metrics.mean_wait_time());
+         result["mean_run_time"] = seconds(metrics.mean_run_time());
+         result["elapsed_time"] = seconds(metrics.elapsed_time);
+         result["utilization"] = metrics.utilization();
+         result["wait_histogram"] = std::vector<std::uint64_t>(metrics.wait_histogram.begin(), metrics.wait_histogram.end());
+         result["run_histogram"] = std::vector<std::uint64_t>(metrics.run_histogram.begin(), metrics.run_histogram.end());
+         return result;
+     }, "Return queue depth, running tasks, latencies (in seconds), latency histograms (bin i counts tasks of "
+        "2**(i-1) to 2**i microseconds) and utilization of the global thread pool.");
+
+     m.def("reset_thread_pool_metrics", &Concurrent::reset_metrics,
+           "Reset the accumulated counters and latency histograms of the global thread pool.");
+
+     m.def("thread_pool_size", py::overload_cast<>(&Concurrent::threads),
+           "Get the number of worker threads of the global thread pool (the pool is started on first use).");
+
+     m.def("set_thread_pool_size", py::overload_cast<unsigned>(&Concurrent::threads), py::arg("threads"),
+           "Set the number of worker threads of the global thread pool. 0 restores the default: the value of the "
+           "TERSE_NUM_THREADS environment variable or, if that is not set, one less than the number of usable cores.");
+
+     m.def("available_cores", &available_cores,
+           "Get the number of cores this process may use, respecting CPU affinity and cgroup CPU quotas.");
+
+     /**
+      * @brief Make the h5terse filter parameters for compressing chunks of type T
+      * @throws py::value_error if the precision is invalid
+      */
+     auto chunk_parameters = [] <typename T> (std::vector<std::size_t> chunk_dim, Terse_mode mode, std::size_t chunk_size,
+                                              std::size_t block_size, unsigned threads, unsigned precision, T type) {
+         if (precision == 1 || precision > 54)
+             throw py::value_error("The precision must be 0 (lossless) or between 2 and 54 bits.");
+         Terse_filter_parameters parameters;
+         parameters.type_code = terse_type_code_of<T>();
+         if (chunk_size != 0) parameters.chunk_size = chunk_size;
+         if (block_size != 0) parameters.block_size = block_size;
+         parameters.mode = mode;
+         parameters.threads = threads;
+         parameters.precision = precision;
+         parameters.chunk_dim = std::move(chunk_dim);
+         return parameters;
+     };
+
+     /**
+      * @brief Write a compressed chunk directly into a new Python bytes object
+      */
+     auto bytes_of_chunk = [] (Terse_chunk& chunk) {
+         std::size_t size = 0;
+         {
+             py::gil_scoped_release release;
+             size = chunk.size();
+         }
+         auto bytes = py::reinterpret_steal<py::bytes>(PyBytes_FromStringAndSize(nullptr, static_cast<Py_ssize_t>(size)));
+         if (!bytes) throw py::error_already_set();
+         auto* destination = reinterpret_cast<std::uint8_t*>(PyBytes_AS_STRING(bytes.ptr()));
+         {
+             py::gil_scoped_release release;
+             chunk.write(destination);
+         }
+         return bytes;
+     };
+
+     m.def("compress_chunk", [&](py::array data, Terse_mode mode, std::size_t chunk_size, std::size_t block_size,
+                                 unsigned threads, unsigned precision) {
+         data = py::array::ensure(data, py::array::c_style);
+         if (!data) throw py::type_error("compress_chunk requires an array");
+         return select_terse_func(data, [&](auto type) {
+             using T = decltype(type);
+             std::vector<std::size_t> const shape(data.shape(), data.shape() + data.ndim());
+             Terse_chunk chunk(std::span(static_cast<T const*>(data.data()), static_cast<std::size_t>(data.size())),
+                 chunk_parameters(shape, mode, chunk_size, block_size, threads, precision, type));
+             return bytes_of_chunk(chunk);
+         });
+     }, py::arg("data"), py::arg("mode") = Terse_mode::Default, py::arg("chunk_size") = 0, py::arg("block_size") = 0,
+        py::arg("threads") = 0, py::arg("precision") = 0,
+        "Compress an array that forms one HDF5 chunk into the bytes the h5terse filter produces for it, for writing "
+        "with H5Dwrite_chunk (h5py: Dataset.id.write_direct_chunk). The array shape is taken as the chunk shape; the "
+        "other arguments are the filter parameters (0 selects the default).");
+
+     m.def("compress_chunks", [&](py::array data, std::size_t frames_per_chunk, Terse_mode mode, std::size_t chunk_size,
+                                  std::size_t block_size, unsigned threads, unsigned precision) {
+         data = py::array::ensure(data, py::array::c_style);
+         if (!data || data.ndim() == 0) throw py::type_error("compress_chunks requires an array of at least one dimension");
+         std::size_t const frames = data.shape(0);
+         if (frames_per_chunk == 0 || frames % frames_per_chunk != 0)
+             throw py::value_error("The number of frames must be a multiple of frames_per_chunk.");
+         return select_terse_func(data, [&](auto type) {
+             using T = decltype(type);
+             std::vector<std::size_t> shape(data.shape(), data.shape() + data.ndim());
+             shape[0] = frames_per_chunk;
+             std::size_t const values_per_chunk = data.size() / frames * frames_per_chunk;
+             auto const parameters = chunk_parameters(shape, mode, chunk_size, block_size, threads, precision, type);
+             std::span const values(static_cast<T const*>(data.data()), static_cast<std::size_t>(data.size()));
+             std::vector<Terse_chunk> chunks;
+             chunks.reserve(frames / frames_per_chunk);
+             for (std::size_t pos = 0; pos != values.size(); pos += values_per_chunk)
+                 chunks.emplace_back(values.subspan(pos, values_per_chunk), parameters);
+             py::list result;
+             for (auto& chunk : chunks)
+                 result.append(bytes_of_chunk(chunk));
+             return result;
+         });
+     }, py::arg("data"), py::arg("frames_per_chunk"), py::arg("mode") = Terse_mode::Default, py::arg("chunk_size") = 0,
+        py::arg("block_size") = 0, py::arg("threads") = 0, py::arg("precision") = 0,
+        "Split an array along its first axis into HDF5 chunks of frames_per_chunk frames and compress all chunks "
+        "concurrently, as by compress_chunk. Returns a list with the bytes of each chunk.");
+
+     /**
+      * @brief Determine the NumPy dtype of an h5terse filter type code
+      */
+     auto pydtype_of_type_code = [] (Terse_type_code const code) {
+         using enum Terse_type_code;
+         switch (code) {
+             case Int8:    return py::dtype::of<std::int8_t>();
+             case Uint8:   return py::dtype::of<std::uint8_t>();
+             case Int16:   return py::dtype::of<std::int16_t>();
+             case Uint16:  return py::dtype::of<std::uint16_t>();
+             case Int32:   return py::dtype::of<std::int32_t>();
+             case Uint32:  return py::dtype::of<std::uint32_t>();
+             case Int64:   return py::dtype::of<std::int64_t>();
+             case Uint64:  return py::dtype::of<std::uint64_t>();
+             case Float32: return py::dtype::of<float>();
+             case Float64: return py::dtype::of<double>();
+         }
+         throw py::value_error("Invalid type code.");
+     };
+
+     /**
+      * @brief View the bytes of a compressed chunk; the buffer must remain valid while the view is used
+      */
+     auto view_of_chunk = [] (py::buffer_info const& info, std::optional<double> dop) {
+         return Terse_chunk_view(std::span(static_cast<std::uint8_t const*>(info.ptr), static_cast<std::size_t>(info.size * info.itemsize)), dop);
+     };
+
+     /**
+      * @brief The array that receives the values of a chunk: 'out', or a new flat array of 'dtype' (by default, the
+      * type of the compressed values)
+      * @throws py::value_error if 'out' is not a writable C-contiguous array of the size of the chunk
+      */
+     auto array_of_chunk = [pydtype_of_type_code] (Terse_chunk_view const& view, py::object const& dtype, py::object const& out) {
+         py::array result;
+         if (out.is_none())
+             result = py::array(dtype.is_none() ? pydtype_of_type_code(view.type_code()) : py::dtype::from_args(dtype),
+                                std::vector<std::size_t>{view.size()});
+         else {
+             if (!py::isinstance<py::array>(out))
+                 throw py::type_error("out must be a NumPy array.");
+             result = py::reinterpret_borrow<py::array>(out);
+             if (!result.writeable() || !(result.flags() & py::array::c_style))
+                 throw py::value_error("out must be a writable C-contiguous array.");
+         }
+         if (static_cast<std::size_t>(result.size()) != view.size())
+             throw py::value_error("Dimension mismatch: the chunk does not hold the number of values of the array.");
+         return result;
+     };
+
+     m.def("chunk_dtype", [view_of_chunk, pydtype_of_type_code](py::buffer chunk) {
+         py::buffer_info const info = chunk.request();
+         return pydtype_of_type_code(view_of_chunk(info, 0.0).type_code());
+     }, py::arg("chunk"),
+        "Return the dtype of the values that were compressed into the bytes of a chunk written by the h5terse filter.");
+
+     m.def("decompress_chunk", [view_of_chunk, array_of_chunk, select_terse_func](py::buffer chunk, py::object dtype, std::optional<std::vector<std::size_t>> shape,
+                                   std::optional<double> dop, py::object out) {
+         py::buffer_info const info = chunk.request();
+         Terse_chunk_view view = view_of_chunk(info, dop);
+         py::array result = array_of_chunk(view, dtype, out);
+         if (shape && out.is_none())
+             result = result.reshape(std::vector<py::ssize_t>(shape->begin(), shape->end()));
+         select_terse_func(result, [&](auto type) {
+             using T = decltype(type);
+             std::span const destination(static_cast<T*>(result.mutable_data()), view.size());
+             py::gil_scoped_release release;
+             view.prolix(destination);
+         });
+         return result;
+     }, py::arg("chunk"), py::arg("dtype") = py::none(), py::arg("shape") = py::none(), py::arg("dop") = py::none(),
+        py::arg("out") = py::none(),
+        "Decompress the bytes of a chunk written by the h5terse filter (h5py: Dataset.id.read_direct_chunk) into a "
+        "new array of the given dtype (by default, the type of the compressed values) and shape, or into 'out': "
+        "a writable C-contiguous array of the size of the chunk.");
+
+     m.def("decompress_chunks", [view_of_chunk, array_of_chunk, select_terse_func](py::iterable chunks, py::object dtype, std::optional<double> dop, py::object out) {
+         std::vector<py::buffer_info> buffers;
+         std::vector<Terse_chunk_view> views;
+         for (py::handle const chunk : chunks) {
+             buffers.push_back(chunk.cast<py::buffer>().request());
+             views.push_back(view_of_chunk(buffers.back(), 0.0));  // Each chunk is unpacked sequentially by one task
+         }
+         std::vector<py::object> outs(views.size(), py::none());
+         if (!out.is_none()) {
+             outs = out.cast<std::vector<py::object>>();
+             if (outs.size() != views.size())
+                 throw py::value_error("out must hold one array per chunk.");
+         }
+         py::list result;
+         std::vector<std::function<void()>> tasks;
+         for (std::size_t i = 0; i != views.size(); ++i) {
+             py::array array = array_of_chunk(views[i], dtype, outs[i]);
+             tasks.push_back(select_terse_func(array, [&](auto type) -> std::function<void()> {
+                 using T = decltype(type);
+                 std::span const destination(static_cast<T*>(array.mutable_data()), views[i].size());
+                 return [&view = views[i], destination] { view.prolix(destination); };
+             }));
+             result.append(array);
+         }
+         {
+             py::gil_scoped_release release;
+             Concurrent concurrent(dop.value_or(1.0));
+             std::vector<std::future<void>> futures;
+             for (auto const& task : tasks)
+                 futures.push_back(concurrent.background(task));
+             std::exception_ptr error;
+             for (auto& future : futures)
+                 try { future.get(); }
+                 catch (...) { if (!error) error = std::current_exception(); }
+             if (error) std::rethrow_exception(error);
+         }
+         return result;
+     }, py::arg("chunks"), py::arg("dtype") = py::none(), py::arg("dop") = py::none(), py::arg("out") = py::none(),
+        "Decompress several chunks concurrently, one chunk per task of the thread pool, as by decompress_chunk. "
+        "Returns a list with a flat array per chunk, or the arrays of the list 'out'.");
+
+     m.def("read_dataset", [&](py::object dataset, py::object out, double dop) {
+         auto const shape = dataset.attr("shape").cast<std::vector<std::size_t>>();
+         py::dtype const dtype = py::dtype::from_args(dataset.attr("dtype"));
+         py::array result = out.is_none() ? py::array(dtype, shape) : out.cast<py::array>();
+         if (!result.dtype().equal(dtype) || !(result.flags() & py::array::c_style) || !result.writeable() ||
+             std::vector<std::size_t>(result.shape(), result.shape() + result.ndim()) != shape)
+             throw py::value_error("out must be a writable C-contiguous array with the shape and dtype of the dataset.");
+         py::object const id = dataset.attr("id");
+         py::object const chunks = dataset.attr("chunks");
+         py::object const plist = id.attr("get_create_plist")();
+         py::tuple const filter = plist.attr("get_nfilters")().cast<int>() == 1 ? plist.attr("get_filter")(0).cast<py::tuple>() : py::tuple();
+         bool const terse_only = !chunks.is_none() && result.size() != 0 && filter.size() >= 3 &&
+             filter[0].cast<unsigned>() == terse_filter_id && py::len(filter[2]) >= 1;
+         return select_terse_func(result, [&](auto type) -> py::array {
+             using T = decltype(type);
+             if (!terse_only || filter[2].cast<py::tuple>()[0].cast<unsigned>() != static_cast<unsigned>(terse_type_code_of<T>())) {
+                 dataset.attr("read_direct")(result);
+                 return result;
+             }
+             auto const chunk_shape = chunks.cast<std::vector<std::size_t>>();
+             std::span<T> const destination(static_cast<T*>(result.mutable_data()), static_cast<std::size_t>(result.size()));
+             Terse_chunk_reader<T> reader(destination, shape, chunk_shape, dop);
+             if (id.attr("get_num_chunks")().cast<std::size_t>() < reader.number_of_chunks())
+                 std::fill(destination.begin(), destination.end(), dataset.attr("fillvalue").cast<T>());
+             std::vector<std::size_t> offset(shape.size(), 0);
+             for (std::size_t i = 0; i != reader.number_of_chunks(); ++i) {
+                 py::object const info = id.attr("get_chunk_info_by_coord")(py::tuple(py::cast(offset)));
+                 if (!info.attr("byte_offset").is_none()) {
+                     py::tuple const raw = id.attr("read_direct_chunk")(py::tuple(py::cast(offset)));
+                     char* bytes = nullptr;
+                     Py_ssize_t size = 0;
+                     if (PyBytes_AsStringAndSize(raw[1].ptr(), &bytes, &size) != 0) throw py::error_already_set();
+                     std::span const chunk(reinterpret_cast<std::uint8_t const*>(bytes), static_cast<std::size_t>(size));
+                     if (raw[0].cast<unsigned>() & 1)
+                         reader.copy(chunk, offset);
+                     else
+                         reader.decode(std::vector<std::uint8_t>(chunk.begin(), chunk.end()), offset);
+                 }
+                 for (std::size_t d = shape.size(); d-- != 0 && (offset[d] += chunk_shape[d]) >= shape[d]; )
+                     offset[d] = 0;
+             }
+             {
+                 py::gil_scoped_release release;
+                 reader.wait();
+             }
+             return result;
+         });
+     }, py::arg("dataset"), py::arg("out") = py::none(), py::arg("dop") = 1.0,
+        "Read an h5py dataset compressed by the h5terse filter: the compressed chunks are read with read_direct_chunk and "
+        "unpacked in parallel on the thread pool, into 'out' or a new array. Datasets that are not compressed by the "
+        "h5terse filter alone are read with read_direct.");
+
+     m.def("terse_to_hdf5", [](Terse<Concurrent>& terse, py::object group, std::string const& name) {
+         terse_lock lock(terse);
+         if (terse.number_of_frames() == 0)
+             throw py::value_error("Cannot write a Terse object without frames to HDF5.");
+         py::module_ const h5py = py::module_::import("h5py");
+         auto const parameters = Terse_filter_parameters::for_frames(terse);
+         std::vector<std::size_t> shape = parameters.chunk_dim;
+         shape[0] = terse.number_of_frames();
+         py::object const dcpl = h5py.attr("h5p").attr("create")(h5py.attr("h5p").attr("DATASET_CREATE"));
+         dcpl.attr("set_chunk")(py::tuple(py::cast(parameters.chunk_dim)));
+         dcpl.attr("set_filter")(terse_filter_id, h5py.attr("h5z").attr("FLAG_OPTIONAL"), py::tuple(py::cast(parameters.cd_values())));
+         py::object const space = h5py.attr("h5s").attr("create_simple")(py::tuple(py::cast(shape)));
+         py::dtype const dtype = [&] {
+             switch (parameters.type_code) {
+                 case Terse_type_code::Int8:    return py::dtype::of<std::int8_t>();
+                 case Terse_type_code::Uint8:   return py::dtype::of<std::uint8_t>();
+                 case Terse_type_code::Int16:   return py::dtype::of<std::int16_t>();
+                 case Terse_type_code::Uint16:  return py::dtype::of<std::uint16_t>();
+                 case Terse_type_code::Int32:   return py::dtype::of<std::int32_t>();
+                 case Terse_type_code::Uint32:  return py::dtype::of<std::uint32_t>();
+                 case Terse_type_code::Int64:   return py::dtype::of<std::int64_t>();
+                 case Terse_type_code::Uint64:  return py::dtype::of<std::uint64_t>();
+                 case Terse_type_code::Float32: return py::dtype::of<float>();
+                 default:                       return py::dtype::of<double>();
+             }
+         }();
+         py::object const id = h5py.attr("h5d").attr("create")(group.attr("id"), py::bytes(name),
+             h5py.attr("h5t").attr("py_create")(dtype), space, py::arg("dcpl") = dcpl);
+         py::object const dataset = h5py.attr("Dataset")(id);
+         std::vector<std::size_t> offset(shape.size(), 0);
+         for (std::size_t frame = 0; frame != terse.number_of_frames(); ++frame) {
+             offset[0] = frame;
+             std::vector<std::uint8_t> const chunk = terse_frame_chunk(terse, frame);
+             id.attr("write_direct_chunk")(py::tuple(py::cast(offset)),
+                 py::bytes(reinterpret_cast<char const*>(chunk.data()), chunk.size()));
+         }
+         return dataset;
+     }, py::arg("terse"), py::arg("group"), py::arg("name"),
+        "Create an h5py dataset compressed by the h5terse filter that holds each frame of a Terse object as one chunk. "
+        "The compressed frames are written with write_direct_chunk, without decompressing and recompressing them.");
+
+     m.def("hdf5_to_terse", [](py::object dataset) {
+         auto const shape = dataset.attr("shape").cast<std::vector<std::size_t>>();
+         py::object const chunks = dataset.attr("chunks");
+         py::object const id = dataset.attr("id");
+         py::object const plist = id.attr("get_create_plist")();
+         if (shape.size() < 2 || chunks.is_none() || plist.attr("get_nfilters")().cast<int>() != 1 ||
+             plist.attr("get_filter")(0).cast<py::tuple>()[0].cast<unsigned>() != terse_filter_id)
+             throw py::value_error("The dataset is not a stack of frames compressed by the h5terse filter alone.");
+         auto const chunk_shape = chunks.cast<std::vector<std::size_t>>();
+         if (!std::equal(shape.begin() + 1, shape.end(), chunk_shape.begin() + 1))
+             throw py::value_error("The chunks of the dataset do not consist of whole frames.");
+         std::size_t const frame_size = std::accumulate(shape.begin() + 1, shape.end(), std::size_t(1), std::multiplies<>());
+         Terse<Concurrent> terse;
+         std::vector<std::size_t> offset(shape.size(), 0);
+         for (std::size_t first = 0; first < shape[0]; first += chunk_shape[0]) {
+             offset[0] = first;
+             py::tuple const raw = id.attr("read_direct_chunk")(py::tuple(py::cast(offset)));
+             if (raw[0].cast<unsigned>() & 1)
+                 throw py::value_error("The dataset has chunks that are not compressed.");
+             char* bytes = nullptr;
+             Py_ssize_t size = 0;
+             if (PyBytes_AsStringAndSize(raw[1].ptr(), &bytes, &size) != 0) throw py::error_already_set();
+             Terse_view<Concurrent> const view(std::span(reinterpret_cast<std::uint8_t const*>(bytes), static_cast<std::size_t>(size)));
+             if (view.file_size() != static_cast<std::size_t>(size) || view.size() != frame_size || view.number_of_frames() != chunk_shape[0])
+                 throw py::value_error("The chunks of the dataset are not compressed as frames.");
+             terse.push_back(view, 0, shape[0] - first);
+         }
+         return terse;
+     }, py::arg("dataset"),
+        "Return the frames of an h5py dataset compressed by the h5terse filter as a Terse object, without decompressing "
+        "and recompressing them. The chunks must consist of whole frames, as written by terse_to_hdf5.");
+
+     py::class_<frame_iterator, std::shared_ptr<frame_iterator>>(m, "FrameIterator",
+         "Iterator over the frames of a Terse object, which unpacks the next frames in the background.")
+         .def("__iter__", [](py::object self) { return self; })
+         .def("__next__", &frame_iterator::next);
+
+     /**
+      * @brief The compressed data of a frame of a Terse object, exported through the buffer protocol
+      *
+      * The buffer shares ownership of the bytes with the Terse object, which never modifies them, so it remains valid
+      * when the frame is released, e.g. by erase() or shrink_to_fit(), or when the Terse object is destroyed.
+      */
+     struct compressed_frame {
+         std::shared_ptr<std::vector<std::uint8_t> const> bytes;  ///< The compressed data
+     };
+
+     py::class_<compressed_frame>(m, "CompressedFrame", py::buffer_protocol(),
+         "Read-only buffer of the compressed data of a frame, e.g. for memoryview() or pickle.PickleBuffer(). It shares "
+         "the data with the Terse object rather than copying them.")
+         .def_buffer([](compressed_frame& frame) {
+             return py::buffer_info(const_cast<std::uint8_t*>(frame.bytes->data()), 1, py::format_descriptor<std::uint8_t>::format(),
+                                    1, {static_cast<py::ssize_t>(frame.bytes->size())}, {py::ssize_t(1)}, true);
+         })
+         .def("__len__", [](compressed_frame& frame) { return frame.bytes->size(); })
+         .def("__reduce_ex__", [](py::object self, int protocol) {
+             auto const builtins = py::module_::import("builtins");
+             if (protocol >= 5)
+                 return py::make_tuple(builtins.attr("memoryview"), py::make_tuple(py::module_::import("pickle").attr("PickleBuffer")(self)));
+             return py::make_tuple(builtins.attr("bytes"), py::make_tuple(builtins.attr("bytes")(self)));
+         });
+
      /**
       * @brief Python bindings for the Terse class
       */
+     auto terse_size = [](Terse<Concurrent>& self) {
+         terse_lock lock(self);
+         py::gil_scoped_release release;
+         return self.terse_size();
+     };
+
      py::class_<Terse<Concurrent>, std::shared_ptr<Terse<Concurrent>>>(m, "Terse")
          .def(py::init<>(), "Create an empty Terse object")
      
@@ -296,12 +1228,14 @@
               "Initialize a Terse object with a NumPy array and a Terse_mode")
      
          .def(py::init([](py::object py_stream) -> std::shared_ptr<Terse<Concurrent>> {
-             python_istream stream(py_stream);  
-             return std::make_shared<Terse<Concurrent>>(stream);  
+             python_istream stream(py_stream);
+             py::gil_scoped_release release;
+             return std::make_shared<Terse<Concurrent>>(stream);
          }), py::arg("stream"),
               "Create a Terse object from a binary input stream. The stream must contain Terse data preceded by the required XML header.")
      
          .def("insert", [&](Terse<Concurrent>& terse, std::size_t pos, py::array data, Terse_mode mode) {
+             terse_lock lock(terse);
              if (pos > terse.number_of_frames())
                  throw std::invalid_argument("Cannot insert at this position: the terse object has fewer frames that the position requested");
              select_terse_func(data, [&](auto Type) { return insert(terse, pos, data, mode, Type); });
@@ -309,114 +1243,236 @@
               "Insert data into the Terse object at the specified position.")
      
          .def("push_back", [&](Terse<Concurrent>& terse, py::array data, Terse_mode mode) {
+             terse_lock lock(terse);
              select_terse_func(data, [&](auto Type) { return insert(terse, terse.number_of_frames(), data, mode, Type); });
          }, py::arg("data"), py::arg("mode") = Terse_mode::Default,
               "Append data at the end of the Terse object.")
      
-         .def("prolix", [&](Terse<Concurrent>& terse, py::array& data) {
-             select_terse_func(data, [&](auto Type) { return prolix(terse, data, Type); });
+         .def("prolix", [&](Terse<Concurrent>& terse, py::object out, std::size_t start, std::optional<std::size_t> stop) -> py::array {
+             terse_lock lock(terse);
+             std::size_t const last = stop.value_or(terse.number_of_frames());
+             if (start > last || last > terse.number_of_frames())
+                 throw py::index_error("Requested frames not present: the frame range is out of bounds.");
+             py::array data;
+             if (!out.is_none()) {
+                 if (!py::isinstance<py::array>(out))
+                     throw py::type_error("out must be a NumPy array.");
+                 data = py::reinterpret_borrow<py::array>(out);
+             }
+             else if (start == 0 && last == terse.number_of_frames())
+                 data = py::array(pydtype_of_terse(terse), pyshape_of_terse(terse));
+             else {
+                 std::vector<size_t> shape = terse.dim().empty() ? std::vector<size_t>{terse.size()} : terse.dim();
+                 shape.insert(shape.begin(), last - start);
+                 data = py::array(pydtype_of_terse(terse), shape);
+             }
+             select_terse_func(data, [&](auto Type) { return prolix(terse, data, start, last, Type); });
              return data;
-         }, py::arg("data"),
-              "Decompress data into the provided data array.")
+         }, py::arg("out") = py::none(), py::arg("start") = 0, py::arg("stop") = py::none(),
+              "Decompress the frames start to stop (by default all frames) into a new array, or directly into 'out': any "
+              "writable C-contiguous array of the right size, such as an np.memmap or an array in shared memory.")
      
-         .def("prolix", [&](Terse<Concurrent>& terse) -> py::array {
+         .def("__getitem__", [getitem](Terse<Concurrent>& terse, py::object key) {
+             terse_lock lock(terse);
+             return getitem(terse, std::move(key));
+         }, py::arg("key"),
+              "Decompress the selected frames in parallel. terse[i] returns frame i, terse[start:stop:step] and "
+              "terse[[i, j, ...]] (or a boolean mask) return an array of the selected frames. Further indices select "
+              "within the frames, e.g. terse[10:20, 100:200, :].")
+
+         .def("__len__", locked_const(&Terse<Concurrent>::number_of_frames), "Return the number of frames.")
+
+         .def("frames", frames, py::arg("prefetch") = 4, py::arg("start") = 0, py::arg("stop") = py::none(),
+              "Return an iterator over the frames start to stop (by default all frames), which unpacks the next "
+              "'prefetch' frames in the background while the current frame is processed. Frame arrays are reused "
+              "once they are no longer referenced, so the iterator holds at most prefetch + 2 frames. The Terse object "
+              "may be modified while it is iterated; RuntimeError is raised if a frame still to be returned was removed.")
+
+         .def("__iter__", [frames](std::shared_ptr<Terse<Concurrent>> terse) { return frames(std::move(terse), 4, 0, std::nullopt); },
+              "Iterate over the frames, unpacking the next 4 frames in the background (see frames()).")
+
+         .def("__array__", [&](Terse<Concurrent>& terse, py::object dtype, std::optional<bool> copy) -> py::object {
+             terse_lock lock(terse);
+             if (copy.has_value() && !*copy)
+                 throw py::value_error("A Terse object cannot be converted to an array without decompressing it.");
              py::array data(pydtype_of_terse(terse), pyshape_of_terse(terse));
-             select_terse_func(data, [&](auto Type) { return prolix(terse, data, Type); });
-             return data;
-         },
-              "Decompress data into a new data array.")
-     
+             select_terse_func(data, [&](auto Type) { return prolix(terse, data, 0, terse.number_of_frames(), Type); });
+             if (dtype.is_none())
+                 return data;
+             return data.attr("astype")(dtype);
+         }, py::arg("dtype") = py::none(), py::arg("copy") = py::none(),
+              "Decompress all frames, as prolix(), so that np.asarray(terse) works.")
+
+         .def("header", [](Terse<Concurrent>& self) {
+             std::string header;
+             {
+                 terse_lock lock(self);
+                 py::gil_scoped_release release;
+                 header = self.header();
+             }
+             return py::bytes(header);
+         }, "Return the bytes that write() writes before the compressed frames: the XML header and the metadata.")
+
+         .def("compressed_frame", [](Terse<Concurrent>& self, std::size_t pos) {
+             terse_lock lock(self);
+             if (pos >= self.number_of_frames())
+                 throw py::index_error("Requested frame not present: index too high.");
+             py::gil_scoped_release release;
+             return compressed_frame{self.shared_frame(pos)};
+         }, py::arg("pos"),
+            "Return the compressed data of a frame as a read-only buffer, which shares the data rather than copying them.")
+
+         .def(py::pickle(
+             [](Terse<Concurrent>& self) {
+                 terse_lock lock(self);
+                 std::string header;
+                 std::vector<compressed_frame> shared;
+                 {
+                     py::gil_scoped_release release;
+                     header = self.header();
+                     for (std::size_t i = 0; i != self.number_of_frames(); ++i)
+                         shared.push_back(compressed_frame{self.shared_frame(i)});
+                 }
+                 py::list frames;
+                 for (auto& frame : shared)
+                     frames.append(std::move(frame));
+                 return py::make_tuple(py::bytes(header), frames);
+             },
+             [](py::tuple const& state) {
+                 if (state.size() != 2)
+                     throw std::runtime_error("Invalid state of a pickled Terse object.");
+                 auto const header = state[0].cast<py::buffer>().request();
+                 std::vector<py::buffer_info> buffers;
+                 std::vector<std::span<std::uint8_t const>> frames;
+                 for (py::handle const frame : py::object(state[1])) {
+                     buffers.push_back(frame.cast<py::buffer>().request());
+                     frames.emplace_back(static_cast<std::uint8_t const*>(buffers.back().ptr),
+                                         static_cast<std::size_t>(buffers.back().size * buffers.back().itemsize));
+                 }
+                 auto terse = std::make_shared<Terse<Concurrent>>();
+                 {
+                     py::gil_scoped_release release;
+                     Terse_view<Concurrent> const view(std::span(static_cast<std::uint8_t const*>(header.ptr),
+                                                                 static_cast<std::size_t>(header.size * header.itemsize)), frames);
+                     terse->push_back(view);
+                 }
+                 return terse;
+             }),
+             "Pickling stores the header and the compressed frames, which are shared with the Terse object rather than "
+             "copied. With pickle protocol 5, the frames are passed as out-of-band buffers, so they are not copied into "
+             "the pickle either.")
+
          .def("at", [](Terse<Concurrent>& self, std::size_t pos) -> std::shared_ptr<Terse<Concurrent>> {
+             terse_lock lock(self);
              if (pos >= self.number_of_frames())
                  throw py::index_error("Requested frame not present: index too high.");
+             py::gil_scoped_release release;
              return std::make_shared<Terse<Concurrent>>(self.at(pos));
          }, py::arg("pos"),
             "Return a Terse object representing a single frame at the specified position.")
      
-         .def("erase", &Terse<Concurrent>::erase, py::arg("pos"),
+         .def("erase", locked(&Terse<Concurrent>::erase), py::arg("pos"),
               "Erase the frame at the specified position.")
               
          .def("write", [](Terse<Concurrent>& self, py::object stream) {
+             terse_lock lock(self);
              python_ostream out(stream);
+             py::gil_scoped_release release;
              self.write(out);
          }, py::arg("stream"),
             "Write Terse data to a binary output stream.")
  
-         .def("save", [](Terse<Concurrent>& self, const std::string& filename) {
-             std::ofstream outfile(filename, std::ios::binary);
-             if (!outfile.is_open()) {
-                 throw std::runtime_error("Failed to open file for writing");
-             }
-             self.write(outfile);
-             outfile.close();
-         }, 
-         py::arg("filename"),
-         "Save Terse data to a file.")
- 
-         .def_static("load", [](const std::string& filename) -> std::shared_ptr<Terse<Concurrent>> {
-             std::ifstream infile(filename, std::ios::binary);
-             if (!infile.is_open()) {
-                 throw std::runtime_error("Failed to open file for reading");
-             }
-             auto obj = std::make_shared<Terse<Concurrent>>(infile);
-             return obj;
-         }, py::arg("filename"),
-         "Load Terse data from a file.")
+         .def("save", [](Terse<Concurrent>& self, std::filesystem::path const& filename, bool parallel) {
+             terse_lock lock(self);
+             py::gil_scoped_release release;
+             save_terse(self, filename, parallel);
+         },
+         py::arg("filename"), py::arg("parallel") = true,
+         "Save Terse data to a file. With parallel, the compressed frames are written concurrently, each at its offset "
+         "in the file. A Terse object can be saved to the file it was loaded from.")
+
+         .def_static("load", [](std::filesystem::path const& filename, bool mmap, bool lazy) -> std::shared_ptr<Terse<Concurrent>> {
+             py::gil_scoped_release release;
+             return std::make_shared<Terse<Concurrent>>(load_terse<Concurrent>(filename, mmap, lazy));
+         }, py::arg("filename"), py::arg("mmap") = true, py::arg("lazy") = true,
+         "Load Terse data from a file. With mmap, the file is memory-mapped, and with lazy, each frame is read from the "
+         "mapping when it is first used, so that even very large files open instantly; otherwise all frames are read "
+         "in parallel. Without mmap, the file is read as a stream. A memory-mapped file must not be modified while "
+         "frames remain to be read from it.")
      
-         .def_property_readonly("size", &Terse<Concurrent>::size,
+         .def_property_readonly("size", locked_const(&Terse<Concurrent>::size),
                                "Get the number of values in each frame.")
-         .def_property_readonly("number_of_frames", &Terse<Concurrent>::number_of_frames,
+         .def_property_readonly("number_of_frames", locked_const(&Terse<Concurrent>::number_of_frames),
                                "Get the number of frames in the Terse object.")
-         .def_property_readonly("is_signed", &Terse<Concurrent>::is_signed,
+         .def_property_readonly("is_signed", locked_const(&Terse<Concurrent>::is_signed),
                                "Check if the data is stored as signed values.")
-         .def_property_readonly("bits_per_val", &Terse<Concurrent>::bits_per_val,
+         .def_property_readonly("bits_per_val", locked_const(&Terse<Concurrent>::bits_per_val),
                                "Get the number of bits used per value in the compressed data.")
-         .def_property_readonly("terse_size", &Terse<Concurrent>::terse_size,
+         .def_property_readonly("terse_size", terse_size,
                                "Get the size of the compressed data in bytes.")
-         .def_property_readonly("file_size", &Terse<Concurrent>::file_size,
-                               "Get the total file size including headers in bytes.")
-         .def_property_readonly("number_of_bytes", &Terse<Concurrent>::terse_size,
+         .def_property_readonly("file_size", [](Terse<Concurrent>& self) {
+             terse_lock lock(self);
+             py::gil_scoped_release release;
+             return self.file_size();
+         }, "Get the total file size including headers in bytes.")
+         .def_property_readonly("number_of_bytes", terse_size,
                                "Alias for terse_size.")
      
-         .def("metadata", py::overload_cast<std::size_t>(&Terse<Concurrent>::metadata, py::const_), py::arg("frame") = 0,
+         .def("metadata", locked_const(py::overload_cast<std::size_t>(&Terse<Concurrent>::metadata, py::const_)), py::arg("frame") = 0,
               "Get the metadata for the specified frame.")
-         .def("set_metadata", py::overload_cast<std::size_t, std::string const>(&Terse<Concurrent>::metadata),
+         .def("set_metadata", locked(py::overload_cast<std::size_t, std::string const>(&Terse<Concurrent>::metadata)),
               py::arg("frame"), py::arg("metadata"),
               "Set the metadata for the specified frame.")
-         .def("dim", py::overload_cast<>(&Terse<Concurrent>::dim, py::const_),
+         .def("dim", locked_const(py::overload_cast<>(&Terse<Concurrent>::dim, py::const_)),
               "Get the dimensions of the frames.")
          .def("set_dim", [](Terse<Concurrent>& self, const std::vector<size_t>& dims) {
+             terse_lock lock(self);
              if (!self.dim().empty() && std::accumulate(dims.begin(), dims.end(), 1ul, std::multiplies<>()) != self.size())
                  throw py::value_error("The total number of elements must remain unchanged when setting dimensions, unless the Terse object is empty.");
              self.dim(dims);
          }, py::arg("dimensions"),
             "Set the dimensions of the frames.")
-         .def("fractional_precision", py::overload_cast<>(&Terse<Concurrent>::fractional_precision, py::const_),
+         .def("fractional_precision", locked_const(py::overload_cast<>(&Terse<Concurrent>::fractional_precision, py::const_)),
               "Get the fractional precision for floating-point data.")
          .def("set_fractional_precision", [](Terse<Concurrent>& self, double precision) {
+             terse_lock lock(self);
              self.fractional_precision(precision);
          }, py::arg("precision"),
             "Set the fractional precision for floating-point data.")
-         .def("block_size", py::overload_cast<>(&Terse<Concurrent>::block_size, py::const_),
+         .def("block_size", locked_const(py::overload_cast<>(&Terse<Concurrent>::block_size, py::const_)),
               "Get the block size used for compression.")
          .def("set_block_size", [](Terse<Concurrent>& self, std::size_t block_size) {
+             terse_lock lock(self);
              if (self.number_of_frames() > 0)
                  throw py::value_error("Cannot set the block size after frames have been added to the Terse object.");
              self.block_size(block_size);
          }, py::arg("block_size"),
             "Set the block size used for compression.")
-         .def("fast", py::overload_cast<>(&Terse<Concurrent>::fast, py::const_),
+         .def("fast", locked_const(py::overload_cast<>(&Terse<Concurrent>::fast, py::const_)),
               "Check if fast mode is enabled.")
-         .def("set_fast", py::overload_cast<bool>(&Terse<Concurrent>::fast), py::arg("value"),
+         .def("set_fast", locked(py::overload_cast<bool>(&Terse<Concurrent>::fast)), py::arg("value"),
               "Enable or disable fast mode.")
-         .def("small", py::overload_cast<>(&Terse<Concurrent>::small, py::const_),
+         .def("small", locked_const(py::overload_cast<>(&Terse<Concurrent>::small, py::const_)),
               "Check if small mode is enabled.")
-         .def("set_small", py::overload_cast<bool>(&Terse<Concurrent>::small), py::arg("value"),
+         .def("set_small", locked(py::overload_cast<bool>(&Terse<Concurrent>::small)), py::arg("value"),
               "Enable or disable small mode.")
-         .def("dop", py::overload_cast<>(&Terse<Concurrent>::dop, py::const_),
+         .def("dop", locked_const(py::overload_cast<>(&Terse<Concurrent>::dop, py::const_)),
               "Get the degree of parallelism.")
-         .def("set_dop", py::overload_cast<double>(&Terse<Concurrent>::dop), py::arg("value"),
+         .def("set_dop", locked(py::overload_cast<double>(&Terse<Concurrent>::dop)), py::arg("value"),
               "Set the degree of parallelism.")
-         .def("shrink_to_fit", &Terse<Concurrent>::shrink_to_fit,
-              "Reduce memory usage by freeing unused capacity.");
+         .def("wait", wait, "Wait until all frames inserted with insert() or push_back() have been compressed, and "
+              "release the references to their arrays.")
+         .def("flush", wait, "Same as wait().")
+         .def("shrink_to_fit", [](Terse<Concurrent>& self) {
+             terse_lock lock(self);
+             py::gil_scoped_release release;
+             self.shrink_to_fit();
+         },
+              "Reduce memory usage by freeing unused capacity.")
+         .def("cancel", [](Terse<Concurrent>& self) {
+             terse_lock lock(self);
+             py::gil_scoped_release release;
+             return self.cancel();
+         },
+              "Discard all frames whose compression has not finished. Returns the number of discarded frames.");
  }
\ No newline at end of file
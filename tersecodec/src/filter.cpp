@@ -13,62 +13,47 @@
 #include <cstdint>
 #include <unordered_map>
 #include <cstring>
+#include <optional>
+#include <algorithm>
+#include <cmath>
 #include "Concurrent.hpp"
 #include "Terse.hpp"
+#include "Terse_chunk.hpp"
 
 
-#define TERSE_FILTER_ID 32029
-#define TERSE_DEFAULT_CHUNK_SIZE 1 << 18
-#define TYPE_CODE_INT16 0
-#define TYPE_CODE_UINT16 1
-#define TYPE_CODE_INT32 2
-#define TYPE_CODE_UINT32 3
-#define TYPE_CODE_INT8 4
-#define TYPE_CODE_UINT8 5
+#define TERSE_FILTER_ID jpa::terse_filter_id
+#define CD_TYPE_CODE 0
+#define CD_RANK 6
+#define CD_DIMENSIONS 7
 
 /**
  * @brief Packs an HDF5 buffer into a terse-compressed buffer.
  *
  * This function takes an input buffer of type `T` and compresses its contents
- * into a terse-compressed format. If chunking is enabled, the buffer is divided
- * into smaller chunks, which are compressed concurrently.
+ * into a terse-compressed format, as described at jpa::Terse_chunk. The
+ * compressed chunks are written in a single pass into one allocation of exactly
+ * the required size.
  *
  * @tparam T The data type of the elements in the buffer.
  * @param data A double pointer to the input/output buffer. The original buffer
  *             will be freed, and a new compressed buffer will be allocated.
  * @param size A pointer to the size of the input/output buffer. This value will
  *             be updated with the size of the compressed buffer.
- * @param chunk_size The size of chunks for concurrent compression. If set to
- *                   zero, the buffer will not be chunked.
+ * @param parameters The filter parameters.
  * @return The size of the compressed buffer in bytes, or 0 if an error occurs.
  */
 template<typename T>
-std::size_t hdf5_buffer_to_terse(void** data, std::size_t* size, std::size_t chunk_size) {
-    struct Fixed_ostreambuf : public std::streambuf {
-        Fixed_ostreambuf(char* buffer, std::size_t size) { setp(buffer, buffer + size); }
-    };
-    std::span buffer(static_cast<T*>(*data), *size / sizeof(T));
-    jpa::Terse<jpa::Concurrent> terse_chunks;
-    jpa::Terse<jpa::Concurrent> terse_rest;
-    if (chunk_size == 0)
-        terse_chunks.push_back(buffer);
-    else {
-        std::size_t pos = 0;
-        for (; pos + chunk_size < buffer.size(); pos += chunk_size)
-            terse_chunks.push_back(std::span(buffer.data() + pos, chunk_size));
-        terse_rest.push_back(std::span(buffer.data() + pos, buffer.size() - pos));
-    }
-    std::size_t terse_size = terse_chunks.file_size() + terse_rest.file_size();
-    void* new_buf = malloc(terse_size);
+std::size_t hdf5_buffer_to_terse(void** data, std::size_t* size, jpa::Terse_filter_parameters const& parameters) {
+    std::span<T const> buffer(static_cast<T const*>(*data), *size / sizeof(T));
+    jpa::Terse_chunk chunk(buffer, parameters);
+    std::size_t const terse_size = chunk.size();
+    auto* new_buf = static_cast<std::uint8_t*>(malloc(terse_size));
     if (!new_buf) {
         std::cerr << "Allocation of memory failed while compressing data in hdf5_buffer_to_terse"<< std::endl;
         return 0;
     }
-    Fixed_ostreambuf oss_buffer(static_cast<char*>(new_buf), terse_size);
-    std::ostream oss(&oss_buffer);
-    terse_chunks.write(oss);
-    terse_rest.write(oss);
-    free(buffer.data());
+    chunk.write(new_buf);
+    free(*data);
     *data = new_buf;
     return *size = terse_size;
 }
@@ -77,55 +62,40 @@ std::size_t hdf5_buffer_to_terse(void** data, std::size_t* size, std::size_t chu
  * @brief Unpacks a terse-compressed buffer back into an HDF5 buffer.
  *
  * This function reads a terse-compressed buffer and reconstructs the original
- * data into a buffer of type `T`.
+ * data into a buffer of type `T`. The compressed chunks are unpacked in parallel,
+ * directly from the input buffer, without copying the compressed data.
  *
  * @tparam T The data type of the elements in the decompressed buffer.
  * @param data A double pointer to the input/output buffer. The original buffer
  *             will be freed, and a new decompressed buffer will be allocated.
  * @param size A pointer to the size of the input/output buffer. This value will
  *             be updated with the size of the decompressed buffer.
+ * @param parameters The filter parameters, of which only the degree of
+ *                   parallelism applies to decompression.
  * @return The size of the decompressed buffer in bytes, or 0 if an error occurs.
  */
 template<typename T>
-std::size_t terse_to_hdf5_buffer(void** data, std::size_t* size) {
-    struct Fixed_istreambuf : public std::streambuf {
-        char* buffer;
-        std::size_t buffer_size;
-
-        Fixed_istreambuf(char* buffer, std::size_t size) : buffer(buffer), buffer_size(size) { setg(buffer, buffer, buffer + size); }
-
-        std::streampos seekoff(std::streamoff off, std::ios_base::seekdir way, std::ios_base::openmode which = std::ios_base::in) override {
-            switch (way) {
-                case (std::ios_base::beg): setg(buffer, buffer + off, buffer + buffer_size); break;
-                case (std::ios_base::end): setg(buffer, buffer + buffer_size + off, buffer + buffer_size); break;
-                default: gbump(static_cast<int>(off));
-            }
-            return gptr() - eback();
-        }
-
-        std::streampos seekpos(std::streampos pos, std::ios_base::openmode which = std::ios_base::in) override {
-            return seekoff(pos, std::ios_base::beg, which);
+std::size_t terse_to_hdf5_buffer(void** data, std::size_t* size, jpa::Terse_filter_parameters const& parameters) {
+    std::span<std::uint8_t const> buffer(static_cast<std::uint8_t const*>(*data), *size);
+    void* new_buf = nullptr;
+    std::size_t prolix_size = 0;
+    try {
+        jpa::Terse_chunk_view chunk(buffer, parameters.dop());
+        prolix_size = chunk.size();
+        new_buf = malloc(prolix_size * sizeof(T));
+        if (!new_buf) {
+            std::cerr << "Allocation of memory failed while expanding data in terse_to_hdf5_buffer"<< std::endl;
+            return 0;
         }
-    };
-
-    std::span buffer(static_cast<char*>(*data), *size);
-    Fixed_istreambuf iss_buffer(static_cast<char*>(buffer.data()), buffer.size());
-    std::istream iss(&iss_buffer);
-    jpa::Terse<jpa::Concurrent> terse_chunks(iss);
-    std::size_t chunk_size = terse_chunks.size();
-    jpa::Terse<jpa::Concurrent> terse_rest;
-    if (!iss.eof()) terse_rest = jpa::Terse<jpa::Concurrent>(iss);
-    std::size_t prolix_size = terse_chunks.size() * terse_chunks.number_of_frames() + terse_rest.size();
-    void* new_buf = malloc(prolix_size * sizeof(T));
-    if (!new_buf) {
-        std::cerr << "Allocation of memory failed while expanding data in terse_to_hdf5_buffer"<< std::endl;
+        chunk.prolix(std::span<T>(static_cast<T*>(new_buf), prolix_size));
+    }
+    catch (std::exception const& e) {
+        std::cerr << "Invalid Terse data in terse_to_hdf5_buffer: " << e.what() << std::endl;
+        free(new_buf);
         return 0;
     }
     free(*data);
     *data = new_buf;
-    std::span<T> prolix(static_cast<T*>(new_buf), prolix_size);
-    terse_chunks.prolix(std::span(prolix.data(), chunk_size * terse_chunks.number_of_frames()));
-    terse_rest.prolix(std::span(prolix.data() + chunk_size * terse_chunks.number_of_frames(), terse_rest.size()));
     return *size = prolix_size * sizeof(T);
 }
 
@@ -138,36 +108,127 @@ std::size_t terse_to_hdf5_buffer(void** data, std::size_t* size) {
  *
  * @param flags HDF5 filter flags indicating whether to compress or decompress.
  * @param cd_nelmts The number of elements in `cd_values`.
- * @param cd_values Array containing filter parameters (e.g., data type code).
+ * @param cd_values Array containing the data type code, optionally followed by
+ *                  the parameters described at jpa::Terse_filter_parameters.
  * @param bufsize Pointer to the size of the input/output buffer.
  * @param buf Pointer to the input/output buffer.
  * @return The size of the processed buffer, or 0 if an error occurs.
  */
 size_t Terse_filter_cpp(unsigned int flags, size_t cd_nelmts, const unsigned int cd_values[], size_t *bufsize, void **buf) {
-    if (!buf || !bufsize || cd_nelmts == 0 || cd_values == nullptr || cd_values[0] > 5) {
+    if (!buf || !bufsize || cd_nelmts == 0 || cd_values == nullptr) {
         std::cerr << "Invalid arguments provided to Terse_filter" << std::endl;
         return 0;
     }
-    unsigned int data_type_code = cd_values[0];
-    if (flags & H5Z_FLAG_REVERSE) switch (data_type_code) {
-        case TYPE_CODE_INT16:  return terse_to_hdf5_buffer<int16_t> (buf, bufsize);
-        case TYPE_CODE_UINT16: return terse_to_hdf5_buffer<uint16_t>(buf, bufsize);
-        case TYPE_CODE_INT32:  return terse_to_hdf5_buffer<int32_t> (buf, bufsize);
-        case TYPE_CODE_UINT32: return terse_to_hdf5_buffer<uint32_t>(buf, bufsize);
-        case TYPE_CODE_INT8:   return terse_to_hdf5_buffer<int8_t>  (buf, bufsize);
-        case TYPE_CODE_UINT8:  return terse_to_hdf5_buffer<uint8_t> (buf, bufsize);
+    auto const parameters = jpa::Terse_filter_parameters::from_cd_values(cd_nelmts, cd_values);
+    if (!parameters) {
+        std::cerr << "Invalid compression parameters provided to Terse_filter" << std::endl;
+        return 0;
+    }
+    using enum jpa::Terse_type_code;
+    if (flags & H5Z_FLAG_REVERSE) switch (parameters->type_code) {
+        case Int16:  return terse_to_hdf5_buffer<int16_t> (buf, bufsize, *parameters);
+        case Uint16: return terse_to_hdf5_buffer<uint16_t>(buf, bufsize, *parameters);
+        case Int32:  return terse_to_hdf5_buffer<int32_t> (buf, bufsize, *parameters);
+        case Uint32: return terse_to_hdf5_buffer<uint32_t>(buf, bufsize, *parameters);
+        case Int8:   return terse_to_hdf5_buffer<int8_t>  (buf, bufsize, *parameters);
+        case Uint8:  return terse_to_hdf5_buffer<uint8_t> (buf, bufsize, *parameters);
+        case Int64:  return terse_to_hdf5_buffer<int64_t> (buf, bufsize, *parameters);
+        case Uint64: return terse_to_hdf5_buffer<uint64_t>(buf, bufsize, *parameters);
+        case Float32: return terse_to_hdf5_buffer<float>  (buf, bufsize, *parameters);
+        case Float64: return terse_to_hdf5_buffer<double> (buf, bufsize, *parameters);
     }
-    else switch (data_type_code) {
-        case TYPE_CODE_INT16:  return hdf5_buffer_to_terse<int16_t> (buf, bufsize, TERSE_DEFAULT_CHUNK_SIZE);
-        case TYPE_CODE_UINT16: return hdf5_buffer_to_terse<uint16_t>(buf, bufsize, TERSE_DEFAULT_CHUNK_SIZE);
-        case TYPE_CODE_INT32:  return hdf5_buffer_to_terse<int32_t> (buf, bufsize, TERSE_DEFAULT_CHUNK_SIZE);
-        case TYPE_CODE_UINT32: return hdf5_buffer_to_terse<uint32_t>(buf, bufsize, TERSE_DEFAULT_CHUNK_SIZE);
-        case TYPE_CODE_INT8:   return hdf5_buffer_to_terse<int8_t>  (buf, bufsize, TERSE_DEFAULT_CHUNK_SIZE);
-        case TYPE_CODE_UINT8:  return hdf5_buffer_to_terse<uint8_t> (buf, bufsize, TERSE_DEFAULT_CHUNK_SIZE);
+    else switch (parameters->type_code) {
+        case Int16:  return hdf5_buffer_to_terse<int16_t> (buf, bufsize, *parameters);
+        case Uint16: return hdf5_buffer_to_terse<uint16_t>(buf, bufsize, *parameters);
+        case Int32:  return hdf5_buffer_to_terse<int32_t> (buf, bufsize, *parameters);
+        case Uint32: return hdf5_buffer_to_terse<uint32_t>(buf, bufsize, *parameters);
+        case Int8:   return hdf5_buffer_to_terse<int8_t>  (buf, bufsize, *parameters);
+        case Uint8:  return hdf5_buffer_to_terse<uint8_t> (buf, bufsize, *parameters);
+        case Int64:  return hdf5_buffer_to_terse<int64_t> (buf, bufsize, *parameters);
+        case Uint64: return hdf5_buffer_to_terse<uint64_t>(buf, bufsize, *parameters);
+        case Float32: return hdf5_buffer_to_terse<float>  (buf, bufsize, *parameters);
+        case Float64: return hdf5_buffer_to_terse<double> (buf, bufsize, *parameters);
     }
     return 0;
 }
 
+/**
+ * @brief Returns the type code of the Terse filter for an HDF5 datatype.
+ *
+ * @param type_id The HDF5 datatype.
+ * @return The type code, or std::nullopt if the filter does not support the datatype.
+ */
+std::optional<jpa::Terse_type_code> terse_type_code(hid_t type_id) {
+    using enum jpa::Terse_type_code;
+    if (H5Tget_class(type_id) == H5T_FLOAT) switch (H5Tget_size(type_id)) {
+        case 4: return Float32;
+        case 8: return Float64;
+        default: return std::nullopt;
+    }
+    if (H5Tget_class(type_id) != H5T_INTEGER)
+        return std::nullopt;
+    bool const is_signed = H5Tget_sign(type_id) == H5T_SGN_2;
+    switch (H5Tget_size(type_id)) {
+        case 1: return is_signed ? Int8  : Uint8;
+        case 2: return is_signed ? Int16 : Uint16;
+        case 4: return is_signed ? Int32 : Uint32;
+        case 8: return is_signed ? Int64 : Uint64;
+        default: return std::nullopt;
+    }
+}
+
+/**
+ * @brief HDF5 `can_apply` callback of the Terse filter.
+ *
+ * Called when a dataset with the Terse filter is created. Checks that the
+ * datatype of the dataset is supported.
+ *
+ * @param dcpl_id The dataset creation property list.
+ * @param type_id The datatype of the dataset.
+ * @param space_id The dataspace of the dataset.
+ * @return 1 if the filter can compress the dataset, 0 if it cannot.
+ */
+extern "C" htri_t Terse_can_apply(hid_t /* dcpl_id */, hid_t type_id, hid_t /* space_id */) {
+    return terse_type_code(type_id).has_value();
+}
+
+/**
+ * @brief HDF5 `set_local` callback of the Terse filter.
+ *
+ * Called when a dataset with the Terse filter is created. Stores the type code
+ * of the datatype in `cd_values[0]` and the rank and dimensions of the chunks in
+ * `cd_values[6]` and following, so that callers need not provide a type code.
+ * The optional parameters `cd_values[1]` to `cd_values[5]` are kept, or set to 0
+ * (default) if absent.
+ *
+ * @param dcpl_id The dataset creation property list.
+ * @param type_id The datatype of the dataset.
+ * @param space_id The dataspace of the dataset.
+ * @return A non-negative value on success, a negative value on failure.
+ */
+extern "C" herr_t Terse_set_local(hid_t dcpl_id, hid_t type_id, hid_t /* space_id */) {
+    unsigned int flags = 0;
+    std::size_t cd_nelmts = CD_DIMENSIONS + H5S_MAX_RANK;
+    unsigned int cd_values[CD_DIMENSIONS + H5S_MAX_RANK] = {};
+    if (H5Pget_filter_by_id2(dcpl_id, TERSE_FILTER_ID, &flags, &cd_nelmts, cd_values, 0, nullptr, nullptr) < 0)
+        return -1;
+    auto const type_code = terse_type_code(type_id);
+    if (!type_code)
+        return -1;
+    std::vector<unsigned int> values(cd_values, cd_values + std::min(cd_nelmts, std::size_t(CD_RANK)));
+    values.resize(CD_RANK, 0);
+    values[CD_TYPE_CODE] = static_cast<unsigned int>(*type_code);
+    if (!jpa::Terse_filter_parameters::from_cd_values(values.size(), values.data()))
+        return -1;
+    hsize_t chunk_dim[H5S_MAX_RANK];
+    int const rank = H5Pget_chunk(dcpl_id, H5S_MAX_RANK, chunk_dim);
+    if (rank > 0) {
+        values.push_back(static_cast<unsigned int>(rank));
+        values.insert(values.end(), chunk_dim, chunk_dim + rank);
+    }
+    return H5Pmodify_filter(dcpl_id, TERSE_FILTER_ID, flags, values.size(), values.data());
+}
+
 /**
  * @brief Main C-code entry point for the Terse HDF5 filter.
  *
@@ -185,8 +246,10 @@ size_t Terse_filter_cpp(unsigned int flags, size_t cd_nelmts, const unsigned int
  * @return The size of the processed buffer, or 0 if an error occurs.
  */
 extern "C" size_t Terse_filter(unsigned int flags, size_t cd_nelmts, const unsigned int cd_values[],
-                               size_t nbytes, size_t *bufsize, void **buf);extern "C" size_t Terse_filter(unsigned int flags, size_t cd_nelmts, const unsigned int cd_values[],
-                               size_t nbytes, size_t *bufsize, void **buf) {
+                               size_t nbytes, size_t *bufsize, void **buf);
+
+extern "C" size_t Terse_filter(unsigned int flags, size_t cd_nelmts, const unsigned int cd_values[],
+                               size_t /* nbytes */, size_t *bufsize, void **buf) {
     return Terse_filter_cpp(flags, cd_nelmts, cd_values, bufsize, buf);
 }
 
@@ -197,8 +260,8 @@ extern "C" herr_t register_terse_filter() {
        1,
        1,
        "TERSE",
-       NULL,
-       NULL,
+       Terse_can_apply,
+       Terse_set_local,
        Terse_filter
    };
    return H5Zregister(&filter_class);
@@ -211,8 +274,8 @@ extern "C" const void* H5PLget_plugin_info(void) {
        H5Z_FILTER_CONFIG_ENCODE_ENABLED | H5Z_FILTER_CONFIG_DECODE_ENABLED,
        1,
        "TERSE",
-       NULL,
-       NULL,
+       Terse_can_apply,
+       Terse_set_local,
        Terse_filter
    };
    return static_cast<const void*>(&filter_class);
@@ -0,0 +1,339 @@
+//
+//  terse_test.cpp
+//  Terse
+//
+//  Tests of the C++ API for cases that the Python tests do not reach: round trips of the Small_unsigned encoder,
+//  thread pool metrics, cancellation of concurrent compression, shared frames, coroutine awaitables, the Terse_frames range,
+//  the division of HDF5 filter chunks. Returns a non-zero exit status if any test fails.
+//
+
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <future>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <ranges>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Concurrent.hpp"
+#include "Terse.hpp"
+#include "Terse_chunk.hpp"
+#include "Terse_frames.hpp"
+
+using namespace jpa;
+
+namespace {
+
+int failures = 0;
+
+void check(bool const condition, std::string const& test) {
+    if (!condition) {
+        std::cerr << "FAILED: " << test << '\n';
+        ++failures;
+    }
+}
+
+// Compresses 'data' with the given mode and block size, and checks that it unpacks to the same values.
+template <typename T>
+void round_trip(std::vector<T> const& data, Terse_mode const mode, std::size_t const block, std::string const& test) {
+    Terse<> terse;
+    terse.block_size(block);
+    terse.push_back(data, mode);
+    std::vector<T> unpacked(data.size());
+    terse.prolix(unpacked.begin());
+    check(unpacked == data, test + ", block " + std::to_string(block));
+}
+
+// Values up to 'max', with every block of 'block' values containing 'max' at least once.
+template <typename T>
+std::vector<T> block_maxima(std::size_t const size, std::size_t const block, T const max, std::mt19937_64& random) {
+    std::uniform_int_distribution<std::uint64_t> values(0, max);
+    std::vector<T> data(size);
+    for (auto& value : data) value = static_cast<T>(values(random));
+    for (std::size_t from = 0; from < size; from += block) data[from] = max;
+    return data;
+}
+
+void test_small_unsigned_large_blocks(std::mt19937_64& random) {
+    for (std::size_t const block : {25, 32, 48, 64}) {
+        std::poisson_distribution<unsigned> background(2.0);
+        std::vector<std::uint16_t> data(1000);
+        for (auto& value : data) value = static_cast<std::uint16_t>(background(random));
+        for (std::size_t i = 0; i < data.size(); i += 97) data[i] = 1000;
+        round_trip(data, Terse_mode::Small_unsigned, block, "Small_unsigned blocks above 24");
+        for (std::size_t i = 0; i < data.size(); i += 89) data[i] = std::numeric_limits<std::uint16_t>::max();
+        round_trip(data, Terse_mode::Small_unsigned, block, "Small_unsigned blocks above 24 with overloads");
+    }
+}
+
+void test_weak_blocks_of_sixes(std::mt19937_64& random) {
+    for (std::size_t const block : {22, 23, 24}) {
+        // 1000 values leave a partial last block.
+        round_trip(block_maxima<std::uint16_t>(1000, block, 6, random), Terse_mode::Small_unsigned, block,
+                   "Small_unsigned blocks with maximum 6");
+        auto data = block_maxima<std::uint16_t>(1000, block, 6, random);
+        for (std::size_t from = 2 * block; from < data.size(); from += 3 * block) data[from] = 4;
+        round_trip(data, Terse_mode::Small_unsigned, block, "Small_unsigned blocks with maxima 6 and 4");
+        for (std::size_t i = 5; i < data.size(); i += 151) data[i] = std::numeric_limits<std::uint16_t>::max();
+        round_trip(data, Terse_mode::Small_unsigned, block, "Small_unsigned blocks with maximum 6 and overloads");
+    }
+}
+
+void test_masked_64_bit(std::mt19937_64& random) {
+    for (std::size_t const block : {8, 12, 24, 32}) {
+        for (std::uint64_t const max : {std::uint64_t(5), std::uint64_t(6), std::uint64_t(1) << 40}) {
+            auto data = block_maxima<std::uint64_t>(1000, block, max, random);
+            for (std::size_t i = 3; i < data.size(); i += 41) data[i] = std::numeric_limits<std::uint64_t>::max();
+            round_trip(data, Terse_mode::Small_unsigned, block, "Small_unsigned masked 64-bit blocks, max " + std::to_string(max));
+            round_trip(data, Terse_mode::Unsigned, block, "Unsigned masked 64-bit blocks, max " + std::to_string(max));
+        }
+        std::vector<std::uint64_t> overloads(100, std::numeric_limits<std::uint64_t>::max());
+        round_trip(overloads, Terse_mode::Small_unsigned, block, "Small_unsigned fully masked 64-bit blocks");
+        round_trip(overloads, Terse_mode::Unsigned, block, "Unsigned fully masked 64-bit blocks");
+    }
+}
+
+void test_metrics_snapshots_are_consistent() {
+    Concurrent::reset_metrics();
+    std::atomic<bool> done = false;
+    std::thread observer([&done] {
+        while (!done) {
+            auto const metrics = Concurrent::metrics();
+            std::uint64_t run = 0, wait = 0;
+            for (auto const count : metrics.run_histogram) run += count;
+            for (auto const count : metrics.wait_histogram) wait += count;
+            check(run == metrics.completed_tasks && wait == metrics.completed_tasks, "metrics histograms add up to completed_tasks");
+            check(metrics.completed_tasks <= metrics.submitted_tasks, "metrics count no more completed than submitted tasks");
+        }
+    });
+    Concurrent concurrent(1.0);
+    std::vector<std::future<void>> tasks;
+    for (int i = 0; i != 2000; ++i)
+        tasks.push_back(concurrent.background([] {}));
+    for (auto& task : tasks) task.get();
+    done = true;
+    observer.join();
+}
+
+void test_cancel_keeps_empty_frames() {
+    Terse<Concurrent> terse;
+    std::atomic<bool> released = false;
+    terse.push_back(std::vector<std::int32_t>(), Terse_mode::Signed, [&released] { released = true; });
+    while (!released) std::this_thread::yield();  // Compression of the frame has finished
+    terse.metadata(std::string("empty"));
+    check(terse.cancel() == 0, "cancel() discards no completed frame");
+    check(terse.number_of_frames() == 1 && terse.metadata() == "empty", "cancel() keeps a completed empty Signed frame");
+}
+
+// Frames are shared by shared_frame(), at() and insert() rather than copied, and outlive shrink_to_fit() and erase().
+void test_shared_frames(std::mt19937_64& random) {
+    auto const data = block_maxima<std::uint16_t>(1000, 12, 4000, random);
+    Terse<Concurrent> terse;
+    terse.push_back(data);
+    terse.push_back(std::vector<std::uint16_t>(data));
+    auto const shared = terse.shared_frame(1);
+    check(shared->data() == terse.compressed_frame(1).data(), "shared_frame() does not copy the frame");
+    auto single = terse.at(1);
+    check(single.compressed_frame(0).data() == shared->data(), "at() shares the frame");
+    Terse<> plain;
+    plain.push_back(terse);
+    check(plain.compressed_frame(1).data() == terse.compressed_frame(1).data(), "insert() of a Terse object shares its frames");
+    std::vector<std::uint8_t> const bytes(shared->begin(), shared->end());
+    terse.shrink_to_fit();
+    terse.erase(1);
+    single = Terse<Concurrent>();
+    check(*shared == bytes, "a shared frame outlives shrink_to_fit() and erase()");
+    check(terse.compressed_frame(0).size() == bytes.size(), "shrink_to_fit() keeps the remaining frame");
+    std::vector<std::uint16_t> unpacked(data.size());
+    plain.shrink_to_fit();
+    plain.prolix(unpacked.begin(), 1);
+    check(unpacked == data, "a frame unpacks after its data were shared");
+}
+
+// A minimal eagerly started coroutine, whose completion (or exception) is reported through 'finished'.
+struct Task {
+    struct promise_type {
+        std::promise<void> done;
+        Task get_return_object() { return Task{done.get_future()}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() { done.set_value(); }
+        void unhandled_exception() { done.set_exception(std::current_exception()); }
+    };
+    std::future<void> finished;
+};
+
+// A task submitted to a saturated pool is executed by the caller. Tests that block a task wait until the tasks of
+// earlier tests have released the workers.
+void wait_for_idle_pool() {
+    while (Concurrent::metrics().running_tasks != 0) std::this_thread::yield();
+}
+
+Task await_value(Awaitable<int> awaitable, int& result, std::thread::id& resumed_on) {
+    result = co_await awaitable;
+    resumed_on = std::this_thread::get_id();
+}
+
+void test_await_completed_task() {
+    Concurrent concurrent(1.0);
+    auto awaitable = concurrent.awaitable([] { return 42; });
+    while (!awaitable.await_ready()) std::this_thread::yield();
+    int result = 0;
+    std::thread::id resumed_on;
+    await_value(awaitable, result, resumed_on).finished.get();
+    check(result == 42 && resumed_on == std::this_thread::get_id(), "co_await of a completed task does not suspend");
+}
+
+void test_await_pending_task() {
+    wait_for_idle_pool();
+    Concurrent concurrent(1.0);
+    std::promise<void> gate;
+    auto awaitable = concurrent.awaitable([opened = gate.get_future().share()] { opened.wait(); return 7; });
+    int result = 0;
+    std::thread::id resumed_on;
+    auto task = await_value(awaitable, result, resumed_on);
+    check(task.finished.wait_for(std::chrono::milliseconds(10)) == std::future_status::timeout,
+          "co_await of a pending task suspends");
+    gate.set_value();
+    task.finished.get();
+    check(result == 7 && resumed_on != std::this_thread::get_id(), "co_await of a pending task resumes on the worker thread");
+    // Tasks that complete while the coroutine suspends race with await_suspend().
+    for (int i = 0; i != 1000; ++i) {
+        await_value(concurrent.awaitable([i] { return i; }), result, resumed_on).finished.get();
+        if (result != i) {
+            check(false, "co_await of a task that completes while suspending");
+            break;
+        }
+    }
+}
+
+Task await_cancelled(Awaitable<int> awaitable, bool& broken_promise) {
+    try { co_await awaitable; }
+    catch (std::future_error const& error) { broken_promise = error.code() == std::future_errc::broken_promise; }
+}
+
+void test_await_cancelled_task() {
+    wait_for_idle_pool();
+    Concurrent concurrent(Deg_of_parallelism().cores(1));
+    std::promise<void> started, gate;
+    auto running = concurrent.awaitable([&started, opened = gate.get_future().share()] { started.set_value(); opened.wait(); return 1; });
+    started.get_future().wait();  // The next task is queued behind the running one
+    auto queued = concurrent.awaitable([] { return 2; });
+    bool broken_promise = false;
+    auto task = await_cancelled(queued, broken_promise);
+    check(concurrent.cancel() == 1, "cancel() removes the queued task");
+    task.finished.get();
+    check(broken_promise, "co_await of a cancelled task rethrows broken_promise");
+    gate.set_value();
+    check(running.get() == 1, "cancel() does not interrupt a running task");
+}
+
+Task compress_and_unpack(Terse<Concurrent>& terse, std::vector<std::uint16_t> const& data, std::vector<std::uint16_t>& unpacked) {
+    co_await terse.push_back_async(std::vector<std::uint16_t>(data));
+    co_await terse.insert_async(0, data);
+    co_await terse.prolix_async(unpacked, 1);
+}
+
+Task await_frames(std::vector<Awaitable<void>> awaitables, std::size_t& broken_promises) {
+    for (auto& awaitable : awaitables)
+        try { co_await awaitable; }
+        catch (std::future_error const& error) { broken_promises += error.code() == std::future_errc::broken_promise; }
+}
+
+void test_terse_awaitables(std::mt19937_64& random) {
+    auto const data = block_maxima<std::uint16_t>(10000, 12, 1000, random);
+    Terse<Concurrent> terse;
+    std::vector<std::uint16_t> unpacked(data.size());
+    compress_and_unpack(terse, data, unpacked).finished.get();
+    check(terse.number_of_frames() == 2 && unpacked == data, "push_back_async, insert_async and prolix_async into an l-value");
+    std::vector<Awaitable<void>> awaitables;
+    for (int i = 0; i != 32; ++i)
+        awaitables.push_back(terse.push_back_async(std::vector<std::uint16_t>(data)));
+    std::size_t const discarded = terse.cancel();
+    std::size_t broken_promises = 0;
+    await_frames(std::move(awaitables), broken_promises).finished.get();
+    check(broken_promises == discarded && terse.number_of_frames() == 34 - discarded,
+          "co_await of a frame discarded by cancel() rethrows broken_promise");
+}
+
+// Chunks whose two fastest dimensions define tiny frames are divided in flat sub-chunks, not in frames.
+void test_chunk_with_small_frames(std::mt19937_64& random) {
+    auto const data = block_maxima<std::uint16_t>(65536 * 4, 12, 100, random);
+    Terse_filter_parameters parameters;
+    parameters.chunk_dim = {65536, 1, 4};
+    auto const bytes = Terse_chunk(std::span<std::uint16_t const>(data), parameters).bytes();
+    check(bytes.size() < data.size() * sizeof(std::uint16_t) / 2, "chunk with frames of 4 values is compressed flat");
+    std::vector<std::uint16_t> unpacked(data.size());
+    Terse_chunk_view(bytes).prolix(std::span(unpacked));
+    check(unpacked == data, "chunk with frames of 4 values round trip");
+    parameters.chunk_dim = {4, 256, 256};
+    auto const frames = Terse_chunk(std::span<std::uint16_t const>(data), parameters).bytes();
+    Terse_chunk_view(frames).prolix(std::span(unpacked));
+    check(unpacked == data, "chunk divided in frames round trip");
+}
+
+static_assert(std::ranges::input_range<Terse_frames<std::uint16_t, Terse<Concurrent>>>);
+static_assert(std::ranges::view<Terse_frames<float, Terse<Concurrent>>>);
+
+void test_terse_frames(std::mt19937_64& random) {
+    std::size_t const frames = 10, frame_size = 50000;
+    std::vector<std::vector<std::uint16_t>> data;
+    Terse<Concurrent> terse;
+    for (std::size_t i = 0; i != frames; ++i) {
+        data.push_back(block_maxima<std::uint16_t>(frame_size, 12, 4000, random));
+        terse.push_back(std::vector<std::uint16_t>(data.back()));  // Compressed in the background while iterating
+    }
+    auto sum = [](std::span<std::uint16_t const> frame) { return std::accumulate(frame.begin(), frame.end(), std::uint64_t(0)); };
+    std::vector<std::uint64_t> sums;
+    for (auto const total : frames_of<std::uint16_t>(terse) | std::views::transform(sum))
+        sums.push_back(total);
+    bool all_equal = sums.size() == frames;
+    for (std::size_t i = 0; all_equal && i != frames; ++i)
+        all_equal = sums[i] == sum(data[i]);
+    check(all_equal, "Terse_frames in a std::views::transform pipeline");
+
+    auto range = frames_of<std::uint16_t>(terse, 2, 3, 7);
+    check(range.size() == 4, "Terse_frames size() of frames first to last");
+    std::size_t frame = 3;
+    all_equal = true;
+    for (std::span<std::uint16_t const> values : range)
+        all_equal = all_equal && std::ranges::equal(values, data[frame++]);
+    check(all_equal && frame == 7, "Terse_frames of frames first to last with fewer buffers than frames");
+    check(std::ranges::empty(frames_of<std::uint16_t>(terse, 4, 5, 5)), "Terse_frames of no frames");
+    try {
+        frames_of<std::uint16_t>(terse, 4, 11);
+        check(false, "Terse_frames with first beyond the last frame throws");
+    }
+    catch (std::out_of_range const&) {}
+
+    {  // Destroying the range waits for the frames that are still being unpacked.
+        auto partial = frames_of<std::uint16_t>(terse, 8);
+        auto it = partial.begin();
+        check(std::ranges::equal(*it, data[0]), "Terse_frames first frame");
+        ++it;
+    }
+}
+
+}  // namespace
+
+int main() {
+    std::mt19937_64 random(42);
+    test_small_unsigned_large_blocks(random);
+    test_weak_blocks_of_sixes(random);
+    test_masked_64_bit(random);
+    test_metrics_snapshots_are_consistent();
+    test_cancel_keeps_empty_frames();
+    test_shared_frames(random);
+    test_await_completed_task();
+    test_await_pending_task();
+    test_await_cancelled_task();
+    test_terse_awaitables(random);
+    test_terse_frames(random);
+    test_chunk_with_small_frames(random);
+    if (failures == 0) std::cout << "All tests passed\n";
+    return failures == 0 ? 0 : 1;
+}